@@ -0,0 +1,280 @@
+#include "AlarmManager.h"
+#include "SafePrint.h" //safe printf in multi-threaded environment
+
+AlarmManager::AlarmManager(Buzzer* buzzer) : buzzer(buzzer) {
+	thr = std::thread(&AlarmManager::worker, this);
+}
+
+AlarmManager::~AlarmManager() {
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		running = false;
+	}
+	cv.notify_one();
+	thr.join();
+}
+
+int AlarmManager::addSource(const SourceConfig& config) {
+	std::lock_guard<std::mutex> lock(mtx);
+	Source s;
+	s.config = config;
+	s.alarm.source = sources.size();
+	s.alarm.name = config.name;
+	sources.push_back(s);
+	return s.alarm.source;
+}
+
+bool AlarmManager::setLimits(int source, double low, double high) {
+	std::lock_guard<std::mutex> lock(mtx);
+	if (source < 0 || source >= (int)sources.size()) return false;
+	sources[source].config.low = low;
+	sources[source].config.high = high;
+	return true;
+}
+
+bool AlarmManager::setConfig(int source, const SourceConfig& config) {
+	std::lock_guard<std::mutex> lock(mtx);
+	if (source < 0 || source >= (int)sources.size()) return false;
+	sources[source].config = config;
+	sources[source].alarm.name = config.name;
+	return true;
+}
+
+AlarmManager::SourceConfig AlarmManager::getConfig(int source) {
+	std::lock_guard<std::mutex> lock(mtx);
+	if (source < 0 || source >= (int)sources.size()) return SourceConfig();
+	return sources[source].config;
+}
+
+// called with mtx held
+AlarmManager::Condition AlarmManager::evaluate(const Source& s, double value) const {
+	const SourceConfig& c = s.config;
+	// a raised condition holds until the value is hysteresis back inside its limit
+	if (s.alarm.condition == ABOVE && value > c.high - c.hysteresis && !(value < c.low)) return ABOVE;
+	if (s.alarm.condition == BELOW && value < c.low + c.hysteresis && !(value > c.high)) return BELOW;
+	if (value > c.high) return ABOVE;
+	if (value < c.low) return BELOW;
+	return NORMAL;
+}
+
+AlarmManager::Condition AlarmManager::reportValue(int source, double value, int64_t timestampNs) {
+	std::lock_guard<std::mutex> lock(mtx);
+	if (source < 0 || source >= (int)sources.size()) return NORMAL;
+	Source& s = sources[source];
+	s.lastValue = value;
+	s.lastTimestampNs = timestampNs;
+	return update(s, evaluate(s, value), Clock::now());
+}
+
+AlarmManager::Condition AlarmManager::reportCondition(int source, bool present, int64_t timestampNs) {
+	std::lock_guard<std::mutex> lock(mtx);
+	if (source < 0 || source >= (int)sources.size()) return NORMAL;
+	Source& s = sources[source];
+	s.lastTimestampNs = timestampNs;
+	return update(s, present ? DETECTED : NORMAL, Clock::now());
+}
+
+// called with mtx held
+AlarmManager::Condition AlarmManager::update(Source& s, Condition condition, Clock::time_point now) {
+	Alarm& a = s.alarm;
+	// a latched alarm whose condition comes back is no longer latched
+	Condition raised = a.latched ? NORMAL : a.condition;
+	if (condition == raised) {
+		if (s.waiting && s.pending != NORMAL && !s.held) stats.suppressed++;
+		s.waiting = false;
+		s.held = false;
+		s.pending = condition;
+		if (condition != NORMAL) stats.merged++;
+		return a.condition;
+	}
+	if (!s.waiting || s.pending != condition) {
+		if (s.waiting && s.pending != NORMAL && !s.held) stats.suppressed++;
+		s.waiting = true;
+		s.held = false;
+		s.pending = condition;
+		s.pendingSince = now;
+	}
+	if (due(s, now) <= now) {
+		s.waiting = false;
+		change(s, condition);
+	} else {
+		cv.notify_one(); // the worker applies it at the end of the delay
+	}
+	return a.condition;
+}
+
+/**
+ * Time the pending condition of s takes effect: after its raise or clear delay, and a raise
+ * no sooner than minInterval after the last one. Called with mtx held.
+ */
+AlarmManager::Clock::time_point AlarmManager::due(Source& s, Clock::time_point now) {
+	std::chrono::milliseconds delay = s.pending == NORMAL ? s.config.clearDelay : s.config.raiseDelay;
+	Clock::time_point at = s.pendingSince + delay;
+	// a latched alarm whose condition comes back is merged, not raised again
+	bool raise = s.pending != NORMAL && !(s.alarm.latched && s.pending == s.alarm.condition);
+	if (raise && s.raisedBefore && s.lastRaised + s.config.minInterval > at) {
+		if (at <= now && !s.held) {
+			s.held = true;
+			stats.rateLimited++;
+		}
+		at = s.lastRaised + s.config.minInterval;
+	}
+	return at;
+}
+
+// called with mtx held
+void AlarmManager::change(Source& s, Condition condition) {
+	Alarm& a = s.alarm;
+	a.value = s.lastValue;
+	a.timestampNs = s.lastTimestampNs;
+	if (condition == NORMAL) {
+		if (s.config.latching && !a.acknowledged) {
+			a.latched = true;
+			SafePrint::printf("[AlarmManager::change()] : %s : %s alarm latched, waiting for acknowledge\n\r",
+					  a.name.c_str(), conditionName(a.condition));
+			notify(s);
+			return;
+		}
+		SafePrint::printf("[AlarmManager::change()] : %s : %s alarm cleared\n\r", a.name.c_str(), conditionName(a.condition));
+		stopSound(s);
+		a.condition = NORMAL;
+		a.latched = false;
+		a.acknowledged = false;
+		stats.cleared++;
+		notify(s);
+		return;
+	}
+	if (a.latched && condition == a.condition) {
+		// back before it was acknowledged, still the same alarm
+		a.latched = false;
+		stats.merged++;
+		notify(s);
+		return;
+	}
+	bool wasRaised = a.condition != NORMAL;
+	s.held = false;
+	s.raisedBefore = true;
+	s.lastRaised = Clock::now();
+	a.condition = condition;
+	a.latched = false;
+	if (!wasRaised) a.acknowledged = false;
+	stats.raised++;
+	if (std::isnan(a.value)) {
+		SafePrint::printf("⚠️ [ALERT!] [AlarmManager::change()] : %s : %s\n\r", a.name.c_str(), conditionName(condition));
+	} else {
+		SafePrint::printf("⚠️ [ALERT!] [AlarmManager::change()] : %s : %s (%.2f, limits [%.2f, %.2f])\n\r",
+				  a.name.c_str(), conditionName(condition), a.value, s.config.low, s.config.high);
+	}
+	if (!a.acknowledged) startSound(s);
+	notify(s);
+}
+
+// called with mtx held
+void AlarmManager::notify(const Source& s) {
+	for (auto& listener : listeners) listener(s.alarm);
+}
+
+// called with mtx held
+void AlarmManager::startSound(const Source& s) {
+	if (!buzzer || s.config.silent) return;
+	buzzer->play(s.config.sound);
+}
+
+// called with mtx held
+void AlarmManager::stopSound(const Source& s) {
+	if (!buzzer || s.config.silent || s.config.sound.repeat != 0) return; // a finite pattern ends by itself
+	int priority = s.config.sound.priority;
+	for (const Source& other : sources) {
+		if (&other == &s || other.config.silent || other.config.sound.priority != priority) continue;
+		if (other.alarm.condition != NORMAL && !other.alarm.acknowledged) return; // still needed
+	}
+	buzzer->cancel(priority);
+}
+
+void AlarmManager::acknowledge(int source) {
+	std::lock_guard<std::mutex> lock(mtx);
+	if (source < 0 || source >= (int)sources.size()) return;
+	Source& s = sources[source];
+	Alarm& a = s.alarm;
+	if (a.condition == NORMAL || a.acknowledged) return;
+	stopSound(s);
+	a.acknowledged = true;
+	SafePrint::printf("[AlarmManager::acknowledge()] : %s : %s alarm acknowledged\n\r", a.name.c_str(), conditionName(a.condition));
+	if (a.latched) {
+		change(s, NORMAL);
+	} else {
+		notify(s);
+	}
+}
+
+void AlarmManager::acknowledgeAll() {
+	int n;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		n = sources.size();
+	}
+	for (int i = 0; i < n; i++) acknowledge(i);
+}
+
+void AlarmManager::addListener(Listener listener) {
+	std::lock_guard<std::mutex> lock(mtx);
+	listeners.push_back(std::move(listener));
+}
+
+void AlarmManager::removeListeners() {
+	std::lock_guard<std::mutex> lock(mtx);
+	listeners.clear();
+}
+
+AlarmManager::Alarm AlarmManager::getAlarm(int source) {
+	std::lock_guard<std::mutex> lock(mtx);
+	if (source < 0 || source >= (int)sources.size()) return Alarm();
+	return sources[source].alarm;
+}
+
+AlarmManager::Stats AlarmManager::getStats() {
+	std::lock_guard<std::mutex> lock(mtx);
+	return stats;
+}
+
+void AlarmManager::printStats() {
+	Stats s = getStats();
+	SafePrint::printf("[AlarmManager] : alarms raised %llu, cleared %llu, reports merged %llu, suppressed by the raise delay %llu, held back by the minimum interval %llu\n\r",
+			  (unsigned long long)s.raised, (unsigned long long)s.cleared,
+			  (unsigned long long)s.merged, (unsigned long long)s.suppressed,
+			  (unsigned long long)s.rateLimited);
+}
+
+const char* AlarmManager::conditionName(Condition condition) {
+	switch (condition) {
+	case NORMAL: return "normal";
+	case ABOVE: return "above high limit";
+	case BELOW: return "below low limit";
+	case DETECTED: return "detected";
+	}
+	return "?";
+}
+
+/**
+ * Applies the pending conditions whose delay has passed without a report that changed them,
+ * e.g. the end of a motion when the PIR stays quiet.
+ */
+void AlarmManager::worker() {
+	std::unique_lock<std::mutex> lock(mtx);
+	while (running) {
+		Clock::time_point now = Clock::now();
+		Clock::time_point next = Clock::time_point::max();
+		for (Source& s : sources) {
+			if (!s.waiting) continue;
+			Clock::time_point at = due(s, now);
+			if (at <= now) {
+				s.waiting = false;
+				change(s, s.pending);
+			} else if (at < next) {
+				next = at;
+			}
+		}
+		if (next == Clock::time_point::max()) cv.wait(lock);
+		else cv.wait_until(lock, next);
+	}
+}
@@ -0,0 +1,182 @@
+#ifndef ALARM_MANAGER_H
+#define ALARM_MANAGER_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include "buzzer.h"
+#include <stdint.h>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * AlarmManager keeps the alarm state of every alarm source (temperature sensors, PIRs) in one
+ * state machine and drives the buzzer and the listeners (GUI, logs) from it, so that a
+ * condition lasting for a while gives one raise and one clear instead of an alarm per sample.
+ *
+ * Per source:
+ * - value sources report measurements, which are compared against low/high limits; an alarm
+ *   only clears once the value is hysteresis back inside the limit
+ * - condition sources report the condition itself (e.g. motion detected / ended)
+ * - a new condition must persist for raiseDelay before it is raised, a cleared one for
+ *   clearDelay before the alarm clears (debounce in time, the source's samples or a timer)
+ * - an alarm is raised again no sooner than minInterval after its last raise, so that a value
+ *   swinging across a limit does not restart the sound on every swing (rate limit)
+ * - a latching alarm stays raised after its condition has gone until acknowledge()
+ * - reports of the raised condition are merged into the raised alarm
+ *
+ * All methods are thread-safe and don't block on the buzzer. The listeners are called with the
+ * manager locked, in the order of the changes, and must not call back into the manager.
+ */
+class AlarmManager {
+
+public:
+    enum Condition {
+	NORMAL = 0,    // no alarm
+	ABOVE = 1,     // value above the high limit
+	BELOW = 2,     // value below the low limit
+	DETECTED = 3   // condition of a condition source present
+    };
+
+    struct SourceConfig {
+	std::string name;                          // for logs and listeners, e.g. "TMP117 1"
+	double low = -INFINITY;                    // limits of a value source
+	double high = INFINITY;
+	double hysteresis = 0;                     // distance back inside a limit to clear
+	std::chrono::milliseconds raiseDelay{0};   // a condition must persist this long to raise
+	std::chrono::milliseconds clearDelay{0};   // normal must persist this long to clear
+	std::chrono::milliseconds minInterval{0};  // least time from one raise to the next
+	bool latching = false;                     // stays raised until acknowledged
+	/**
+	 * Played when the alarm is raised. A pattern repeated until cancelled (repeat 0) sounds
+	 * while the alarm is raised and not acknowledged; patterns of sources sharing its
+	 * priority keep it going until the last of them clears.
+	 **/
+	Buzzer::Pattern sound;
+	bool silent = false;                       // no sound at all
+    };
+
+    struct Alarm {
+	int source = -1;
+	std::string name;
+	Condition condition = NORMAL; // raised condition, NORMAL when clear
+	bool latched = false;         // raised but the condition has gone, waiting for acknowledge()
+	bool acknowledged = false;
+	double value = NAN;           // value that caused the last change (value sources)
+	int64_t timestampNs = 0;      // wall clock time of that report
+    };
+
+    using Listener = std::function<void(const Alarm&)>;
+
+    struct Stats {
+	uint64_t raised = 0;     // alarms raised
+	uint64_t cleared = 0;    // alarms cleared
+	uint64_t merged = 0;     // reports of an already raised condition
+	uint64_t suppressed = 0; // conditions that went away within raiseDelay
+	uint64_t rateLimited = 0; // raises held back by minInterval
+    };
+
+    /**
+     * \param buzzer Buzzer played on raised alarms, may be nullptr.
+     **/
+    explicit AlarmManager(Buzzer* buzzer);
+    ~AlarmManager();
+
+    AlarmManager(const AlarmManager&) = delete;
+    AlarmManager& operator=(const AlarmManager&) = delete;
+
+    // Registers a source, the returned id is passed to the report methods.
+    int addSource(const SourceConfig& config);
+
+    /**
+     * Changes the limits of a value source; the current state is re-evaluated with the next report.
+     * \return false if source is not a valid id.
+     **/
+    bool setLimits(int source, double low, double high);
+
+    /**
+     * Replaces the configuration of source (limits, hysteresis, delays, latching, sound). A
+     * raised alarm stays raised and is re-evaluated with the next report.
+     * \return false if source is not a valid id.
+     **/
+    bool setConfig(int source, const SourceConfig& config);
+    SourceConfig getConfig(int source);
+
+    /**
+     * Reports a measurement of a value source.
+     * \param timestampNs Wall clock time of the measurement, passed on to the listeners.
+     * \return the raised condition of the source after this report.
+     **/
+    Condition reportValue(int source, double value, int64_t timestampNs);
+
+    /**
+     * Reports whether the condition of a condition source is present.
+     * \return the raised condition of the source after this report.
+     **/
+    Condition reportCondition(int source, bool present, int64_t timestampNs);
+
+    /**
+     * Acknowledges the alarm of source: its sound stops and a latched alarm clears. An alarm
+     * whose condition is still present clears normally when the condition goes.
+     **/
+    void acknowledge(int source);
+    void acknowledgeAll();
+
+    void addListener(Listener listener);
+    // No listener is called after this returns, e.g. before the GUI is torn down.
+    void removeListeners();
+
+    Alarm getAlarm(int source);
+    Stats getStats();
+    void printStats();
+
+    static const char* conditionName(Condition condition);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Source {
+	SourceConfig config;
+	Alarm alarm;
+	Condition pending = NORMAL;      // instantaneous condition from the last report
+	Clock::time_point pendingSince;  // time the pending condition first differed from the alarm
+	bool waiting = false;            // pending differs from the raised condition
+	bool held = false;               // the pending raise is held back by minInterval
+	bool raisedBefore = false;
+	Clock::time_point lastRaised;    // time of the last raise, for minInterval
+	double lastValue = NAN;
+	int64_t lastTimestampNs = 0;
+    };
+
+    Buzzer* buzzer;
+    std::vector<Source> sources;
+    std::vector<Listener> listeners;
+    Stats stats;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::thread thr;     // applies raise and clear delays when no report comes in
+    bool running = true;
+
+    Condition evaluate(const Source& s, double value) const;
+    Condition update(Source& s, Condition condition, Clock::time_point now);
+    Clock::time_point due(Source& s, Clock::time_point now);
+    void change(Source& s, Condition condition);
+    void notify(const Source& s);
+    void startSound(const Source& s);
+    void stopSound(const Source& s);
+    void worker();
+};
+
+#endif // ALARM_MANAGER_H
@@ -0,0 +1,206 @@
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include <stdint.h>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+/**
+ * AsyncLog is the backend of SafePrint::printf(): the calling thread formats its message into
+ * a slot of a bounded multi-producer ring (Vyukov's sequence-numbered slots, one CAS to claim a
+ * slot) and returns; a background thread takes the messages in order and writes them to stdout
+ * in batches, with one fflush() per batch. Logging threads never take a lock and never wait for
+ * the terminal, so a slow SSH session no longer serialises the acquisition threads.
+ *
+ * Memory is bounded: when the ring is full the message is dropped and counted, the writer
+ * reports the number of dropped messages with the next batch. Messages longer than
+ * RECORD_SIZE are truncated.
+ *
+ * Messages still queued are written at exit (atexit); after that, and when set synchronous,
+ * messages are written directly under a mutex as before.
+ */
+class AsyncLog {
+
+public:
+    static constexpr size_t SLOTS = 4096;        // power of two, 1 MiB of messages
+    static constexpr size_t RECORD_SIZE = 256;   // bytes per message including the terminator
+
+    static AsyncLog& get() {
+	// never destroyed: objects destroyed at exit may still log, they are written synchronously
+	static AsyncLog* instance = new AsyncLog();
+	return *instance;
+    }
+
+    void vprintf(const char* format, va_list args) {
+	if (synchronous.load(std::memory_order_relaxed)) {
+	    std::lock_guard<std::mutex> lock(writeMutex);
+	    ::vprintf(format, args);
+	    fflush(stdout);
+	    return;
+	}
+	size_t pos = enqueuePos.load(std::memory_order_relaxed);
+	Slot* slot;
+	while (true) {
+	    slot = &slots[pos & (SLOTS - 1)];
+	    size_t seq = slot->seq.load(std::memory_order_acquire);
+	    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+	    if (diff == 0) {
+		if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+	    } else if (diff < 0) {
+		dropped.fetch_add(1, std::memory_order_relaxed); // full, the writer is behind
+		return;
+	    } else {
+		pos = enqueuePos.load(std::memory_order_relaxed);
+	    }
+	}
+	int len = vsnprintf(slot->text, RECORD_SIZE, format, args);
+	if (len < 0) len = 0;
+	if ((size_t)len >= RECORD_SIZE) {
+	    len = RECORD_SIZE - 1;
+	    memcpy(slot->text + RECORD_SIZE - 6, "...\n\r", 5); // truncated
+	}
+	slot->len = len;
+	slot->seq.store(pos + 1, std::memory_order_release);
+	// wake the writer if it has gone to sleep, see writer()
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (sleeping.load(std::memory_order_relaxed) && sleeping.exchange(false)) {
+	    uint64_t one = 1;
+	    if (write(wakeFd, &one, sizeof(one)) < 0) {}
+	}
+    }
+
+    /**
+     * Writes everything queued so far before returning. Switching to synchronous drains the
+     * ring first, e.g. before the process forks or when output must not be reordered against
+     * other writes to stdout.
+     **/
+    void flush() {
+	size_t target = enqueuePos.load(std::memory_order_acquire);
+	while (running.load(std::memory_order_acquire) && written.load(std::memory_order_acquire) < target) {
+	    wake();
+	    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+    }
+
+    void setSynchronous(bool on) {
+	if (on) flush();
+	synchronous.store(on, std::memory_order_relaxed);
+    }
+
+    // messages dropped because the ring was full, cumulative
+    uint64_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+	std::atomic<size_t> seq;
+	uint16_t len;
+	char text[RECORD_SIZE];
+    };
+
+    Slot slots[SLOTS];
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) size_t dequeuePos = 0;             // writer thread only
+    std::atomic<size_t> written{0};                // messages taken by the writer
+    std::atomic<uint64_t> dropped{0};
+    uint64_t droppedReported = 0;                  // writer thread only
+    std::atomic<bool> sleeping{false};
+    std::atomic<bool> synchronous{false};
+    std::atomic<bool> running{true};
+    std::mutex writeMutex;
+    int wakeFd;
+    std::thread thr;
+    std::string batch;                             // writer thread only
+
+    AsyncLog() {
+	for (size_t i = 0; i < SLOTS; i++) slots[i].seq.store(i, std::memory_order_relaxed);
+	wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (wakeFd < 0) {
+	    synchronous = true;
+	    return;
+	}
+	batch.reserve(SLOTS * 64);
+	thr = std::thread(&AsyncLog::writer, this);
+	atexit([]() { get().shutdown(); });
+    }
+
+    void wake() {
+	sleeping.store(false, std::memory_order_relaxed);
+	uint64_t one = 1;
+	if (write(wakeFd, &one, sizeof(one)) < 0) {}
+    }
+
+    // takes the messages that are complete, in order. \return false if there were none
+    bool drain() {
+	batch.clear();
+	while (true) {
+	    Slot& slot = slots[dequeuePos & (SLOTS - 1)];
+	    if (slot.seq.load(std::memory_order_acquire) != dequeuePos + 1) break;
+	    batch.append(slot.text, slot.len);
+	    slot.seq.store(dequeuePos + SLOTS, std::memory_order_release);
+	    dequeuePos++;
+	}
+	uint64_t drops = dropped.load(std::memory_order_relaxed);
+	if (drops != droppedReported) {
+	    char note[96];
+	    snprintf(note, sizeof(note), "[SafePrint] : [WARNING] : %llu message(s) dropped, log output too slow\n\r",
+		     (unsigned long long)(drops - droppedReported));
+	    batch += note;
+	    droppedReported = drops;
+	}
+	if (batch.empty()) return false;
+	{
+	    std::lock_guard<std::mutex> lock(writeMutex);
+	    fwrite(batch.data(), 1, batch.size(), stdout);
+	    fflush(stdout);
+	}
+	written.store(dequeuePos, std::memory_order_release);
+	return true;
+    }
+
+    void writer() {
+	while (running.load(std::memory_order_acquire)) {
+	    if (drain()) continue;
+	    // no message: sleep until a producer sees the flag, then look once more (lost wakeup)
+	    sleeping.store(true, std::memory_order_relaxed);
+	    std::atomic_thread_fence(std::memory_order_seq_cst);
+	    if (drain()) {
+		sleeping.store(false, std::memory_order_relaxed);
+		continue;
+	    }
+	    // the timeout is only a safety net, producers write wakeFd when they see the flag
+	    pollfd pfd = { wakeFd, POLLIN, 0 };
+	    poll(&pfd, 1, 100);
+	    uint64_t n;
+	    if (read(wakeFd, &n, sizeof(n)) < 0) {}
+	}
+	drain();
+    }
+
+    // at exit: write what is queued, then write synchronously
+    void shutdown() {
+	synchronous.store(true, std::memory_order_relaxed);
+	running.store(false, std::memory_order_release);
+	wake();
+	if (thr.joinable()) thr.join();
+    }
+};
+
+#endif // ASYNC_LOG_H
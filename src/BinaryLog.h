@@ -0,0 +1,278 @@
+#ifndef BINARY_LOG_H
+#define BINARY_LOG_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include "SafePrint.h"
+#include <stdint.h>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * SAFE_PRINTF(format, ...) logs like SafePrint::printf(format, ...), but while the binary log is
+ * open the message is not formatted at all: the call site registers its format string once (on
+ * its first call) and afterwards only the format id, a timestamp and the raw arguments are
+ * appended to a memory-mapped log file, typically 20 - 30 bytes instead of a formatted line.
+ * binlog_decode renders the file as text offline.
+ *
+ * Arguments may be integers, enums, bool, floating point and C strings, as the format expects.
+ */
+#define SAFE_PRINTF(format, ...) do { \
+	if (BinaryLog::get().isOpen()) { \
+	    static BinaryLog::Site safePrintSite_{format}; \
+	    BinaryLog::get().log(safePrintSite_, ##__VA_ARGS__); \
+	} else { \
+	    SafePrint::printf(format, ##__VA_ARGS__); \
+	} \
+    } while (0)
+
+/**
+ * File layout, all values little endian as written by the target:
+ *   FileHeader
+ *   records, each 8 byte aligned: RecordHeader, then
+ *     FORMAT  : argument signature and format string, both NUL terminated
+ *     MESSAGE : uint64 monotonic time in ns, then the arguments in signature order:
+ *               'i' int32, 'I' int64, 'u' uint32, 'U' uint64, 'd' double,
+ *               's' uint16 length + bytes (no terminator)
+ * A record becomes valid when its size is stored, which is done last; the records end at the
+ * first size of 0. The file is created sparse, space not yet logged to takes no blocks.
+ *
+ * Writers reserve their record with one atomic add on the write offset and never block. When
+ * the file is full further messages are dropped and counted in the header.
+ */
+class BinaryLog {
+
+public:
+    static constexpr char MAGIC[8] = { 'S', 'M', 'S', 'B', 'L', 'O', 'G', '1' };
+    static constexpr size_t MAX_STRING = 255; // longer string arguments are truncated
+
+    enum RecordType : uint16_t {
+	FORMAT = 1,
+	MESSAGE = 2
+    };
+
+    struct FileHeader {
+	char magic[8];
+	uint64_t capacity;        // file size in bytes
+	int64_t realtimeOffsetNs; // CLOCK_REALTIME - CLOCK_MONOTONIC when the log was opened
+	uint64_t dropped;         // messages that did not fit any more
+	char reserved[32];
+    };
+
+    struct RecordHeader {
+	uint32_t size;            // whole record including padding, 0 = end of the log
+	uint16_t type;
+	uint16_t formatId;
+    };
+
+    // call site of SAFE_PRINTF, registered with the log on its first call
+    struct Site {
+	const char* format;
+	std::atomic<uint16_t> id{0};
+    };
+
+    static BinaryLog& get() {
+	// never destroyed, like AsyncLog: objects destroyed at exit may still log
+	static BinaryLog* instance = new BinaryLog();
+	return *instance;
+    }
+
+    /**
+     * Creates the log file at path with room for size bytes and switches SAFE_PRINTF to it.
+     * Opened once per process.
+     * \return false if the file could not be created or mapped.
+     **/
+    bool open(const std::string& path, size_t size) {
+	std::lock_guard<std::mutex> lock(mtx);
+	if (base) return false;
+	size &= ~(size_t)7;
+	if (size < sizeof(FileHeader) + 4096) {
+	    SafePrint::printf("[BinaryLog::open()] : [ERROR] : %s : size too small\n\r", path.c_str());
+	    return false;
+	}
+	int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0 || ftruncate(fd, size) < 0) {
+	    SafePrint::printf("[BinaryLog::open()] : [ERROR] : %s : %s\n\r", path.c_str(), strerror(errno));
+	    if (fd >= 0) ::close(fd);
+	    return false;
+	}
+	void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED) {
+	    SafePrint::printf("[BinaryLog::open()] : [ERROR] : %s : %s\n\r", path.c_str(), strerror(errno));
+	    return false;
+	}
+	base = (char*)map;
+	capacity = size;
+	header()->capacity = size;
+	header()->realtimeOffsetNs = clockNs(CLOCK_REALTIME) - clockNs(CLOCK_MONOTONIC);
+	header()->dropped = 0;
+	memcpy(header()->magic, MAGIC, sizeof(MAGIC));
+	tail.store(sizeof(FileHeader), std::memory_order_relaxed);
+	SafePrint::printf("[BinaryLog::open()] : logging to %s (%zu KiB), decode with binlog_decode\n\r", path.c_str(), size / 1024);
+	opened.store(true, std::memory_order_release);
+	atexit([]() { get().close(); });
+	return true;
+    }
+
+    /**
+     * Switches SAFE_PRINTF back to text and writes the log back to the file. The mapping stays
+     * in place for writers that are still inside log().
+     **/
+    void close() {
+	std::lock_guard<std::mutex> lock(mtx);
+	if (!opened.exchange(false)) return;
+	msync(base, capacity, MS_SYNC);
+    }
+
+    bool isOpen() const { return opened.load(std::memory_order_acquire); }
+
+    uint64_t getDropped() const { return base ? __atomic_load_n(&header()->dropped, __ATOMIC_RELAXED) : 0; }
+
+    template <typename... Args>
+    void log(Site& site, const Args&... args) {
+	uint16_t id = site.id.load(std::memory_order_acquire);
+	if (id == 0) {
+	    const char signature[] = { tag<Args>()..., '\0' };
+	    id = define(site, signature);
+	    if (id == 0) return;
+	}
+	size_t size = sizeof(RecordHeader) + sizeof(uint64_t) + (argSize(args) + ... + 0);
+	RecordHeader* record = reserve(size);
+	if (!record) return;
+	char* p = (char*)(record + 1);
+	uint64_t now = clockNs(CLOCK_MONOTONIC);
+	memcpy(p, &now, sizeof(now));
+	p += sizeof(now);
+	(put(p, args), ...);
+	record->type = MESSAGE;
+	record->formatId = id;
+	commit(record, size);
+    }
+
+private:
+    char* base = nullptr;
+    size_t capacity = 0;
+    std::atomic<uint64_t> tail{0};
+    std::atomic<bool> opened{false};
+    std::mutex mtx;                 // open, close and the registration of call sites
+    uint16_t nextId = 1;
+
+    BinaryLog() {}
+
+    FileHeader* header() const { return (FileHeader*)base; }
+
+    static int64_t clockNs(clockid_t clock) {
+	timespec ts;
+	clock_gettime(clock, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    template <typename T>
+    static constexpr char tag() {
+	using U = std::decay_t<T>;
+	if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*>) return 's';
+	else if constexpr (std::is_floating_point_v<U>) return 'd';
+	else if constexpr (std::is_enum_v<U>) return tag<std::underlying_type_t<U>>();
+	else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) return sizeof(U) <= 4 ? 'i' : 'I';
+	else if constexpr (std::is_integral_v<U>) return sizeof(U) <= 4 ? 'u' : 'U';
+	else static_assert(std::is_integral_v<U>, "SAFE_PRINTF: unsupported argument type");
+    }
+
+    static size_t stringLength(const char* s) { return s ? strnlen(s, MAX_STRING) : 0; }
+
+    template <typename T>
+    static size_t argSize(const T& v) {
+	constexpr char t = tag<T>();
+	if constexpr (t == 's') return sizeof(uint16_t) + stringLength(v);
+	else if constexpr (t == 'i' || t == 'u') return 4;
+	else return 8;
+    }
+
+    template <typename T>
+    static void put(char*& p, const T& v) {
+	constexpr char t = tag<T>();
+	if constexpr (t == 's') {
+	    uint16_t len = stringLength(v);
+	    memcpy(p, &len, sizeof(len));
+	    memcpy(p + sizeof(len), v, len);
+	    p += sizeof(len) + len;
+	} else if constexpr (t == 'd') {
+	    double d = v;
+	    memcpy(p, &d, sizeof(d));
+	    p += sizeof(d);
+	} else if constexpr (t == 'i') {
+	    int32_t i = v;
+	    memcpy(p, &i, sizeof(i));
+	    p += sizeof(i);
+	} else if constexpr (t == 'u') {
+	    uint32_t u = v;
+	    memcpy(p, &u, sizeof(u));
+	    p += sizeof(u);
+	} else if constexpr (t == 'I') {
+	    int64_t i = v;
+	    memcpy(p, &i, sizeof(i));
+	    p += sizeof(i);
+	} else {
+	    uint64_t u = v;
+	    memcpy(p, &u, sizeof(u));
+	    p += sizeof(u);
+	}
+    }
+
+    // \return the record space, nullptr if the file is full
+    RecordHeader* reserve(size_t& size) {
+	size = (size + 7) & ~(size_t)7;
+	uint64_t offset = tail.fetch_add(size, std::memory_order_relaxed);
+	if (offset + size > capacity) {
+	    if (__atomic_fetch_add(&header()->dropped, 1, __ATOMIC_RELAXED) == 0) {
+		SafePrint::printf("[BinaryLog::log()] : [WARNING] : log file full, messages are dropped\n\r");
+	    }
+	    return nullptr;
+	}
+	return (RecordHeader*)(base + offset);
+    }
+
+    // the record is complete for the decoder once its size is visible
+    static void commit(RecordHeader* record, size_t size) {
+	__atomic_store_n(&record->size, (uint32_t)size, __ATOMIC_RELEASE);
+    }
+
+    // writes the FORMAT record of a call site, once. \return its id, 0 if there was no room
+    uint16_t define(Site& site, const char* signature) {
+	std::lock_guard<std::mutex> lock(mtx);
+	uint16_t id = site.id.load(std::memory_order_relaxed);
+	if (id != 0 || !base) return id;
+	if (nextId == UINT16_MAX) return 0;
+	size_t sigLen = strlen(signature) + 1;
+	size_t formatLen = strlen(site.format) + 1;
+	size_t size = sizeof(RecordHeader) + sigLen + formatLen;
+	RecordHeader* record = reserve(size);
+	if (!record) return 0;
+	char* p = (char*)(record + 1);
+	memcpy(p, signature, sigLen);
+	memcpy(p + sigLen, site.format, formatLen);
+	id = nextId++;
+	record->type = FORMAT;
+	record->formatId = id;
+	commit(record, size);
+	site.id.store(id, std::memory_order_release);
+	return id;
+    }
+};
+
+#endif // BINARY_LOG_H
@@ -0,0 +1,197 @@
+#include "ControlServer.h"
+#include "SafePrint.h" //safe printf in multi-threaded environment
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// longest command line accepted, a client sending more is disconnected
+#define CONTROL_LINE_MAX 256
+// a client that sends nothing for this long is disconnected so that the next one is served
+#define CONTROL_IDLE_TIMEOUT_MS 30000
+
+ControlServer::ControlServer(SensorRegistry& sensors, AlarmManager* alarms) : sensors(sensors), alarms(alarms) {
+}
+
+ControlServer::~ControlServer() {
+	stop();
+}
+
+bool ControlServer::start(const std::string& path) {
+	if (listenFd >= 0) return true;
+	sockaddr_un addr = {};
+	addr.sun_family = AF_UNIX;
+	if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+		SafePrint::printf("[ControlServer::start()] : [ERROR] : invalid socket path '%s'\n\r", path.c_str());
+		return false;
+	}
+	strcpy(addr.sun_path, path.c_str());
+
+	listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (listenFd < 0 || wakeFd < 0) {
+		SafePrint::printf("[ControlServer::start()] : [ERROR] : %s\n\r", strerror(errno));
+		stop();
+		return false;
+	}
+	unlink(path.c_str()); // left behind by a previous run
+	if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 4) < 0) {
+		SafePrint::printf("[ControlServer::start()] : [ERROR] : %s : %s\n\r", path.c_str(), strerror(errno));
+		stop();
+		return false;
+	}
+	chmod(path.c_str(), 0660); // owner and group only
+	this->path = path;
+	thr = std::thread(&ControlServer::worker, this);
+	SafePrint::printf("[ControlServer::start()] : listening on %s\n\r", path.c_str());
+	return true;
+}
+
+void ControlServer::stop() {
+	if (thr.joinable()) {
+		uint64_t one = 1;
+		if (write(wakeFd, &one, sizeof(one)) < 0) {
+			SafePrint::printf("[ControlServer::stop()] : [ERROR] : %s\n\r", strerror(errno));
+		}
+		thr.join();
+	}
+	if (listenFd >= 0) close(listenFd);
+	if (wakeFd >= 0) close(wakeFd);
+	listenFd = wakeFd = -1;
+	if (!path.empty()) unlink(path.c_str());
+	path.clear();
+}
+
+void ControlServer::worker() {
+	pollfd fds[2] = { { wakeFd, POLLIN, 0 }, { listenFd, POLLIN, 0 } };
+	while (true) {
+		if (poll(fds, 2, -1) < 0) {
+			if (errno == EINTR) continue;
+			SafePrint::printf("[ControlServer::worker()] : [ERROR] : %s\n\r", strerror(errno));
+			return;
+		}
+		if (fds[0].revents) return;
+		if (!fds[1].revents) continue;
+		int fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+		if (fd < 0) continue;
+		serve(fd);
+		close(fd);
+	}
+}
+
+// reads command lines from one client until it disconnects, goes idle or stop() is called
+void ControlServer::serve(int fd) {
+	std::string buffer;
+	pollfd fds[2] = { { wakeFd, POLLIN, 0 }, { fd, POLLIN, 0 } };
+	while (true) {
+		int n = poll(fds, 2, CONTROL_IDLE_TIMEOUT_MS);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0 || fds[0].revents) return;
+		char chunk[CONTROL_LINE_MAX];
+		ssize_t len = read(fd, chunk, sizeof(chunk));
+		if (len <= 0) return;
+		buffer.append(chunk, len);
+		size_t eol;
+		while ((eol = buffer.find('\n')) != std::string::npos) {
+			std::string reply = execute(buffer.substr(0, eol));
+			buffer.erase(0, eol + 1);
+			if (reply.empty()) continue;
+			if (send(fd, reply.data(), reply.size(), MSG_NOSIGNAL) < 0) return;
+		}
+		if (buffer.size() > CONTROL_LINE_MAX) {
+			const char* error = "ERROR line too long\n";
+			send(fd, error, strlen(error), MSG_NOSIGNAL);
+			return;
+		}
+	}
+}
+
+std::string ControlServer::execute(const std::string& line) {
+	std::istringstream in(line);
+	std::string command;
+	if (!(in >> command)) return ""; // blank line
+	int id;
+	TMP117TemperatureSensor* sensor = nullptr;
+
+	if (command == "thresholds") {
+		double low, high;
+		std::string rest;
+		if (!(in >> id >> low >> high) || (in >> rest)) return "ERROR usage: thresholds <id> <low> <high>\n";
+		if (!(sensor = sensors.findSensor(id))) return "ERROR unknown sensor\n";
+		if (!(low < high)) return "ERROR low must be below high\n";
+		bool written = sensor->setThresholds(low, high);
+		SafePrint::printf("[ControlServer] : sensor %d : thresholds set to [%.2f, %.2f] °C\n\r", id, low, high);
+		if (onThresholdsChanged) onThresholdsChanged(id, low, high);
+		return written ? "OK\n" : "ERROR limits could not be written to the sensor\n";
+	}
+	if (command == "rate") {
+		double perMinute;
+		std::string rest;
+		if (!(in >> id >> perMinute) || (in >> rest)) return "ERROR usage: rate <id> <°C/min>\n";
+		if (!(sensor = sensors.findSensor(id))) return "ERROR unknown sensor\n";
+		if (!(perMinute >= 0)) return "ERROR rate must not be negative\n";
+		sensor->setRateLimit(perMinute);
+		SafePrint::printf("[ControlServer] : sensor %d : rate limit set to %.2f °C/min\n\r", id, perMinute);
+		return "OK\n";
+	}
+	if (command == "ack") {
+		std::string which;
+		if (!(in >> which)) return "ERROR usage: ack <id>|all\n";
+		if (!alarms) return "ERROR no alarm manager\n";
+		if (which == "all") {
+			alarms->acknowledgeAll();
+			return "OK\n";
+		}
+		char* end;
+		id = strtol(which.c_str(), &end, 0);
+		if (*end != '\0' || !(sensor = sensors.findSensor(id))) return "ERROR unknown sensor\n";
+		acknowledge(sensor);
+		return "OK\n";
+	}
+	if (command == "sample") {
+		std::string rest;
+		if (!(in >> id) || (in >> rest)) return "ERROR usage: sample <id>\n";
+		if (!(sensor = sensors.findSensor(id))) return "ERROR unknown sensor\n";
+		if (!sensors.getSampleScheduler().requestNow(sensor)) return "ERROR sensor is not sampled on demand\n";
+		return "OK\n";
+	}
+	if (command == "status") {
+		std::string reply;
+		for (size_t i = 0; i < sensors.size(); i++) {
+			sensor = &sensors.getSensor(i);
+			double low, high;
+			sensor->getThresholds(low, high);
+			double rate = sensor->getRate();
+			double limit = sensor->getRateLimit();
+			char buf[256];
+			snprintf(buf, sizeof(buf), "sensor %d thresholds %.2f %.2f rate %.2f limit %.2f", sensor->getSensorId(),
+				 low, high, std::isnan(rate) ? 0.0 : rate, limit);
+			reply += buf;
+			if (alarms) {
+				AlarmManager::Alarm alarm = alarms->getAlarm(sensor->getAlarmSource());
+				AlarmManager::Alarm rateAlarm = alarms->getAlarm(sensor->getRateAlarmSource());
+				reply += std::string(" alarm ") + AlarmManager::conditionName(alarm.condition);
+				if (rateAlarm.condition != AlarmManager::NORMAL) reply += ", rising fast";
+			}
+			reply += "\n";
+		}
+		return reply + "OK\n";
+	}
+	if (command == "help") {
+		return "thresholds <id> <low> <high>\nrate <id> <°C/min>\nack <id>|all\nsample <id>\nstatus\nOK\n";
+	}
+	return "ERROR unknown command, try help\n";
+}
+
+void ControlServer::acknowledge(TMP117TemperatureSensor* sensor) {
+	alarms->acknowledge(sensor->getAlarmSource());
+	alarms->acknowledge(sensor->getRateAlarmSource());
+}
@@ -0,0 +1,66 @@
+#ifndef CONTROL_SERVER_H
+#define CONTROL_SERVER_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include "SensorRegistry.h"
+#include "AlarmManager.h"
+#include <functional>
+#include <string>
+#include <thread>
+
+/**
+ * ControlServer changes the alarm settings of the running system through a local Unix domain
+ * socket, one command per line, answered with "OK", "ERROR <reason>" or the requested lines:
+ *   thresholds <id> <low> <high>   alert range of sensor id in °C
+ *   rate <id> <°C/min>             rate of change limit of sensor id, 0 = off
+ *   ack <id>|all                   acknowledges the alarms of sensor id or all alarms
+ *   sample <id>                    samples sensor id now (one-shot and alert/therm mode sensors)
+ *   status                         thresholds, rate and alarm of every sensor
+ *   help
+ * e.g. echo "thresholds 1 18 26" | socat - UNIX-CONNECT:/tmp/smart_system.sock
+ * Clients are served one after the other on the server's own thread.
+ */
+class ControlServer {
+
+public:
+    /**
+     * \param alarms Alarm manager of the sensors, may be nullptr (no ack).
+     **/
+    ControlServer(SensorRegistry& sensors, AlarmManager* alarms);
+    ~ControlServer();
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    /**
+     * Listens on path, a stale socket file left there is replaced.
+     * \return false if the socket could not be set up.
+     **/
+    bool start(const std::string& path);
+    void stop();
+
+    // called on the server thread with sensor id, low and high after the thresholds changed
+    std::function<void(int, double, double)> onThresholdsChanged;
+
+private:
+    SensorRegistry& sensors;
+    AlarmManager* alarms;
+    std::string path;
+    int listenFd = -1;
+    int wakeFd = -1;     // eventfd, wakes the server thread up for stop()
+    std::thread thr;
+
+    void worker();
+    void serve(int fd);
+    std::string execute(const std::string& line);
+    void acknowledge(TMP117TemperatureSensor* sensor);
+};
+
+#endif // CONTROL_SERVER_H
@@ -0,0 +1,36 @@
+#ifndef GPIOD_COMPAT_H
+#define GPIOD_COMPAT_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+/**
+ * The GPIO code is built against libgpiod v1 by default, or against libgpiod v2 when
+ * GPIOD_V2 is defined (set by CMake from the installed libgpiod version).
+ *
+ * The callbacks (GPIOPin::GPIOEventCallbackInterface) and the TimestampService keep using
+ * the v1 event struct for both: with v2 it is defined here and GPIOPin fills it from the
+ * gpiod_edge_event, with the same CLOCK_MONOTONIC timestamp.
+ */
+#include <gpiod.h>
+
+#ifdef GPIOD_V2
+#include <time.h>
+
+enum {
+    GPIOD_LINE_EVENT_RISING_EDGE = GPIOD_EDGE_EVENT_RISING_EDGE,
+    GPIOD_LINE_EVENT_FALLING_EDGE = GPIOD_EDGE_EVENT_FALLING_EDGE,
+};
+
+struct gpiod_line_event {
+    struct timespec ts;
+    int event_type;
+};
+#endif
+
+#endif // GPIOD_COMPAT_H
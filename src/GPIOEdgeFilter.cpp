@@ -0,0 +1,118 @@
+#include "GPIOEdgeFilter.h"
+#include "TimestampService.h"
+
+void GPIOEdgeFilter::configure(const Options& options) {
+	this->options = options;
+	if (this->options.rateBurst < 1) this->options.rateBurst = 1;
+	tokens = this->options.rateBurst;
+	lastRefillNs = 0;
+	level = -1;
+	hasHeld = false;
+	hasPulseStart = false;
+	suppressing = false;
+}
+
+bool GPIOEdgeFilter::enabled() const {
+	return needsTimer() || options.pairPulses || options.maxPulsesPerSecond > 0;
+}
+
+bool GPIOEdgeFilter::needsTimer() const {
+	return options.minPulseWidth.count() > 0 || options.holdOff.count() > 0;
+}
+
+bool GPIOEdgeFilter::isActive(const gpiod_line_event& e) const {
+	return (e.event_type == GPIOD_LINE_EVENT_RISING_EDGE) == options.activeHigh;
+}
+
+void GPIOEdgeFilter::input(const gpiod_line_event& e, std::vector<gpiod_line_event>& out) {
+	int64_t t = TimestampService::toNs(e.ts);
+	// a held edge whose time has passed by the kernel clock is released first
+	expire(t, out);
+
+	bool active = isActive(e);
+	if (hasHeld) {
+		if (isActive(held) != active) {
+			// the line went back before the hold time: a glitch, or a gap that merges two pulses
+			if (isActive(held)) nGlitches++;
+			else nMerged++;
+			hasHeld = false;
+		}
+		// an edge of the same direction means the kernel lost one in between, the held one stays
+		return;
+	}
+	if (level == (active ? 1 : 0)) {
+		nDuplicates++;
+		return;
+	}
+
+	int64_t hold = (active ? options.minPulseWidth : options.holdOff).count() * 1000LL;
+	if (hold > 0) {
+		held = e;
+		hasHeld = true;
+		releaseNs = t + hold;
+		return;
+	}
+	release(e, out);
+}
+
+void GPIOEdgeFilter::expire(int64_t nowNs, std::vector<gpiod_line_event>& out) {
+	if (!hasHeld || releaseNs > nowNs) return;
+	hasHeld = false;
+	release(held, out);
+}
+
+bool GPIOEdgeFilter::takeToken(int64_t ns) {
+	if (options.maxPulsesPerSecond <= 0) return true;
+	if (lastRefillNs != 0) {
+		tokens += (ns - lastRefillNs) * 1e-9 * options.maxPulsesPerSecond;
+		if (tokens > options.rateBurst) tokens = options.rateBurst;
+	}
+	lastRefillNs = ns;
+	if (tokens < 1) return false;
+	tokens -= 1;
+	return true;
+}
+
+void GPIOEdgeFilter::release(const gpiod_line_event& e, std::vector<gpiod_line_event>& out) {
+	bool active = isActive(e);
+	level = active ? 1 : 0;
+	if (active) {
+		if (!takeToken(TimestampService::toNs(e.ts))) {
+			nRateLimited++;
+			suppressing = true;
+			return;
+		}
+		if (options.pairPulses) {
+			pulseStart = e;
+			hasPulseStart = true;
+			return;
+		}
+		out.push_back(e);
+		return;
+	}
+
+	if (suppressing) {
+		suppressing = false;
+		return;
+	}
+	if (options.pairPulses) {
+		if (!hasPulseStart) {
+			nUnpaired++;
+			return;
+		}
+		// the whole pulse in one burst
+		out.push_back(pulseStart);
+		hasPulseStart = false;
+	}
+	out.push_back(e);
+}
+
+GPIOEdgeFilter::Stats GPIOEdgeFilter::getStats() const {
+	Stats s;
+	s.glitches = nGlitches;
+	s.merged = nMerged;
+	s.duplicates = nDuplicates;
+	s.unpaired = nUnpaired;
+	s.rateLimited = nRateLimited;
+	return s;
+}
@@ -0,0 +1,95 @@
+#ifndef GPIO_EDGE_FILTER_H
+#define GPIO_EDGE_FILTER_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include "GPIODCompat.h"
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+/**
+ * GPIOEdgeFilter turns the raw edges of a line into clean events before they reach the
+ * callbacks, using only the kernel timestamps of the edges (CLOCK_MONOTONIC):
+ * - minimum pulse width: an active edge is held back for minPulseWidth; if the line returns
+ *   before, both edges are dropped as a glitch
+ * - hold-off: an inactive edge is held back for holdOff; if the line becomes active again
+ *   before, both edges are dropped, so pulses closer than holdOff merge into one
+ * - duplicates: edges that don't change the filtered level are dropped
+ * - pairing: an active edge is only delivered together with its inactive edge, as one burst
+ *   of two, so that a callback sees whole pulses (start and end time)
+ * - rate limit: pulses beyond maxPulsesPerSecond (token bucket of rateBurst pulses) are
+ *   dropped with both their edges
+ *
+ * GPIOPin calls input() for every edge read from the line and expire() when the deadline()
+ * of a held edge has passed (a timer of the GPIOReactor). Not thread-safe, the GPIOReactor
+ * thread is the only user; the counters can be read from any thread.
+ */
+class GPIOEdgeFilter {
+
+public:
+    struct Options {
+	bool activeHigh = true;                          // rising edge starts a pulse
+	std::chrono::microseconds minPulseWidth{0};
+	std::chrono::microseconds holdOff{0};
+	bool pairPulses = false;
+	double maxPulsesPerSecond = 0;                   // 0 = no rate limit
+	unsigned rateBurst = 1;
+    };
+
+    struct Stats {
+	uint64_t glitches = 0;    // pulses shorter than minPulseWidth
+	uint64_t merged = 0;      // gaps shorter than holdOff
+	uint64_t duplicates = 0;  // edges that didn't change the level
+	uint64_t unpaired = 0;    // inactive edges without a delivered active edge (pairing)
+	uint64_t rateLimited = 0; // pulses over the rate limit
+    };
+
+    void configure(const Options& options);
+    const Options& getOptions() const { return options; }
+
+    // true if any filtering is configured
+    bool enabled() const;
+
+    // true if edges can be held back, i.e. expire() must be called at deadline()
+    bool needsTimer() const;
+
+    // Feeds one edge, the edges that become deliverable are appended to out.
+    void input(const gpiod_line_event& e, std::vector<gpiod_line_event>& out);
+
+    // Releases a held edge whose hold time has passed at nowNs (CLOCK_MONOTONIC).
+    void expire(int64_t nowNs, std::vector<gpiod_line_event>& out);
+
+    // CLOCK_MONOTONIC time at which the held edge is released, 0 if no edge is held.
+    int64_t deadline() const { return hasHeld ? releaseNs : 0; }
+
+    Stats getStats() const;
+
+private:
+    Options options;
+
+    int level = -1;                 // filtered level, -1 = not known yet
+    bool hasHeld = false;
+    gpiod_line_event held;
+    int64_t releaseNs = 0;
+    bool hasPulseStart = false;     // pairing: delivered active edge waiting for its end
+    gpiod_line_event pulseStart;
+    bool suppressing = false;       // active edge rate limited, its inactive edge goes too
+    double tokens = 0;
+    int64_t lastRefillNs = 0;
+
+    std::atomic<uint64_t> nGlitches{0}, nMerged{0}, nDuplicates{0}, nUnpaired{0}, nRateLimited{0};
+
+    bool isActive(const gpiod_line_event& e) const;
+    void release(const gpiod_line_event& e, std::vector<gpiod_line_event>& out);
+    bool takeToken(int64_t ns);
+};
+
+#endif // GPIO_EDGE_FILTER_H
@@ -0,0 +1,195 @@
+#include "GPIOExecutor.h"
+#include "TimestampService.h"
+#include <algorithm>
+
+std::mutex GPIOCallbackExecutor::config_mtx;
+ThreadConfig GPIOCallbackExecutor::threadConfig;
+
+void GPIOCallbackExecutor::setThreadConfig(const ThreadConfig& config) {
+	std::lock_guard<std::mutex> lock(config_mtx);
+	threadConfig = config;
+}
+
+ThreadConfig GPIOCallbackExecutor::getThreadConfig() {
+	std::lock_guard<std::mutex> lock(config_mtx);
+	return threadConfig;
+}
+
+GPIOCallbackExecutor::GPIOCallbackExecutor(GPIOPin::GPIOEventCallbackInterface* cb, const GPIOPin::CallbackOptions& options,
+					   LatencyHistogram* dispatch, LatencyHistogram* handled)
+	: cb(cb), options(options), dispatchLatency(dispatch), handledLatency(handled) {
+	if (this->options.queueSize == 0) this->options.queueSize = 1;
+	ring.resize(this->options.queueSize);
+	batch.resize(this->options.queueSize);
+	if (this->options.executor == GPIOPin::SERIAL) {
+		thr = std::thread(&GPIOCallbackExecutor::worker, this);
+	}
+}
+
+GPIOCallbackExecutor::~GPIOCallbackExecutor() {
+	stop();
+}
+
+void GPIOCallbackExecutor::invoke(GPIOPin::GPIOEventCallbackInterface* cb, gpiod_line_event* events, int n,
+				  LatencyHistogram* dispatch, LatencyHistogram* handled) {
+	int64_t started = TimestampService::monotonicNow();
+	cb->hasEvents(events, n);
+	int64_t returned = TimestampService::monotonicNow();
+	if (!dispatch) return; // not a measured edge
+	for (int i = 0; i < n; i++) {
+		int64_t edge = TimestampService::toNs(events[i].ts);
+		dispatch->record(started - edge);
+		handled->record(returned - edge);
+	}
+}
+
+// called with mtx held
+void GPIOCallbackExecutor::push(const gpiod_line_event& e) {
+	if (count == ring.size()) {
+		switch (options.overflow) {
+		case GPIOPin::DROP_NEWEST:
+			stats.dropped++;
+			return;
+		case GPIOPin::DROP_OLDEST:
+			head = (head + 1) % ring.size();
+			count--;
+			stats.dropped++;
+			break;
+		case GPIOPin::MERGE_LATEST:
+			// the newest queued edge is replaced, the line state it reports is stale
+			ring[(head + count - 1) % ring.size()] = e;
+			stats.merged++;
+			return;
+		}
+	}
+	ring[(head + count) % ring.size()] = e;
+	count++;
+	if (count > stats.maxQueued) stats.maxQueued = count;
+}
+
+// called with mtx held, moves all queued edges to batch
+int GPIOCallbackExecutor::take() {
+	int n = count;
+	for (int i = 0; i < n; i++) {
+		batch[i] = ring[(head + i) % ring.size()];
+	}
+	head = (head + n) % ring.size();
+	count = 0;
+	stats.delivered += n;
+	return n;
+}
+
+void GPIOCallbackExecutor::post(const gpiod_line_event* events, int n) {
+	bool schedule = false;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		if (!running) return;
+		for (int i = 0; i < n; i++) push(events[i]);
+		if (options.executor == GPIOPin::POOL && !scheduled && count > 0) {
+			scheduled = true;
+			schedule = true;
+		}
+	}
+	if (schedule) {
+		GPIOThreadPool::get().schedule(this);
+	} else if (options.executor == GPIOPin::SERIAL) {
+		cv.notify_one();
+	}
+}
+
+void GPIOCallbackExecutor::worker() {
+	getThreadConfig().apply("gpio-callback");
+	std::unique_lock<std::mutex> lock(mtx);
+	while (true) {
+		cv.wait(lock, [this]() { return count > 0 || !running; });
+		if (count == 0) break; // stopped and drained
+		int n = take();
+		lock.unlock();
+		invoke(cb, batch.data(), n, dispatchLatency, handledLatency);
+		lock.lock();
+	}
+}
+
+bool GPIOCallbackExecutor::runPooled() {
+	std::unique_lock<std::mutex> lock(mtx);
+	int n = take();
+	lock.unlock();
+	if (n > 0) invoke(cb, batch.data(), n, dispatchLatency, handledLatency);
+	lock.lock();
+	if (count > 0) return true; // stays scheduled, the pool puts it back in line
+	scheduled = false;
+	cv.notify_all(); // stop() may be waiting, notified under the lock as it may destroy us
+	return false;
+}
+
+void GPIOCallbackExecutor::stop() {
+	std::unique_lock<std::mutex> lock(mtx);
+	if (!running) return;
+	running = false;
+	if (options.executor == GPIOPin::SERIAL) {
+		lock.unlock();
+		cv.notify_one();
+		thr.join();
+	} else if (options.executor == GPIOPin::POOL) {
+		cv.wait(lock, [this]() { return !scheduled; });
+	}
+}
+
+void GPIOCallbackExecutor::start() {
+	std::lock_guard<std::mutex> lock(mtx);
+	if (running) return;
+	running = true;
+	if (options.executor == GPIOPin::SERIAL) {
+		thr = std::thread(&GPIOCallbackExecutor::worker, this);
+	}
+}
+
+GPIOCallbackExecutor::Stats GPIOCallbackExecutor::getStats() {
+	std::lock_guard<std::mutex> lock(mtx);
+	return stats;
+}
+
+GPIOThreadPool& GPIOThreadPool::get() {
+	static GPIOThreadPool pool;
+	return pool;
+}
+
+GPIOThreadPool::GPIOThreadPool() {
+	// a small pool, the callbacks are expected to be short
+	unsigned n = std::max(2u, std::min(4u, std::thread::hardware_concurrency()));
+	for (unsigned i = 0; i < n; i++) {
+		threads.emplace_back(&GPIOThreadPool::worker, this);
+	}
+}
+
+GPIOThreadPool::~GPIOThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		running = false;
+	}
+	cv.notify_all();
+	for (auto& t : threads) t.join();
+}
+
+void GPIOThreadPool::schedule(GPIOCallbackExecutor* executor) {
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		ready.push_back(executor);
+	}
+	cv.notify_one();
+}
+
+void GPIOThreadPool::worker() {
+	GPIOCallbackExecutor::getThreadConfig().apply("gpio-pool");
+	std::unique_lock<std::mutex> lock(mtx);
+	while (true) {
+		cv.wait(lock, [this]() { return !ready.empty() || !running; });
+		if (ready.empty()) break;
+		GPIOCallbackExecutor* executor = ready.front();
+		ready.pop_front();
+		lock.unlock();
+		bool more = executor->runPooled();
+		lock.lock();
+		if (more) ready.push_back(executor);
+	}
+}
@@ -0,0 +1,130 @@
+#ifndef GPIO_EXECUTOR_H
+#define GPIO_EXECUTOR_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include "gpioevent.h"
+#include "ThreadConfig.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * GPIOCallbackExecutor runs one GPIO callback off the GPIOReactor thread, as selected with
+ * GPIOPin::CallbackOptions: on its own thread (SERIAL) or on the shared GPIOThreadPool (POOL).
+ * Either way the callback sees the edges in order and is never called concurrently with
+ * itself. The edges wait in a bounded queue; when it is full the overflow policy decides
+ * which edges are given up, so a slow callback can neither block the line nor the other
+ * callbacks of the line. Edges queued while the callback runs are delivered as one burst.
+ */
+class GPIOCallbackExecutor {
+
+public:
+    struct Stats {
+	uint64_t delivered = 0; // edges passed to the callback
+	uint64_t dropped = 0;   // edges given up because the queue was full
+	uint64_t merged = 0;    // edges replaced by a newer one (MERGE_LATEST)
+	uint64_t maxQueued = 0; // longest the queue has been
+    };
+
+    /**
+     * \param dispatch, handled Histograms of the pin for the latency from the edge to the
+     *        start and to the return of the callback.
+     **/
+    GPIOCallbackExecutor(GPIOPin::GPIOEventCallbackInterface* cb, const GPIOPin::CallbackOptions& options,
+			 LatencyHistogram* dispatch, LatencyHistogram* handled);
+    ~GPIOCallbackExecutor();
+
+    GPIOCallbackExecutor(const GPIOCallbackExecutor&) = delete;
+    GPIOCallbackExecutor& operator=(const GPIOCallbackExecutor&) = delete;
+
+    // Queues a burst of edges, called on the GPIOReactor thread. Never blocks on the callback.
+    void post(const gpiod_line_event* events, int n);
+
+    // Delivers the edges still queued and stops, nothing is delivered afterwards.
+    void stop();
+
+    // Starts again after stop(), executors are started when they are created.
+    void start();
+
+    Stats getStats();
+
+    /**
+     * Real-time settings of the callback threads (SERIAL executors and the GPIOThreadPool),
+     * used by the threads started afterwards. Set it before the first callback is registered.
+     **/
+    static void setThreadConfig(const ThreadConfig& config);
+    static ThreadConfig getThreadConfig();
+
+    /**
+     * Calls cb with the burst and records the latencies of its edges, unless the histograms
+     * are nullptr. Used for inline callbacks by GPIOPin as well.
+     **/
+    static void invoke(GPIOPin::GPIOEventCallbackInterface* cb, gpiod_line_event* events, int n,
+		       LatencyHistogram* dispatch, LatencyHistogram* handled);
+
+private:
+    friend class GPIOThreadPool;
+
+    GPIOPin::GPIOEventCallbackInterface* cb;
+    GPIOPin::CallbackOptions options;
+    LatencyHistogram* dispatchLatency;
+    LatencyHistogram* handledLatency;
+
+    // bounded queue of edges, a ring of options.queueSize entries
+    std::vector<gpiod_line_event> ring;
+    size_t head = 0;
+    size_t count = 0;
+    std::vector<gpiod_line_event> batch; // edges taken out of the ring for one call
+    Stats stats;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::thread thr;            // SERIAL only
+    bool running = true;
+    bool scheduled = false;     // POOL: queued on or running in the pool
+
+    static std::mutex config_mtx;
+    static ThreadConfig threadConfig;
+
+    void push(const gpiod_line_event& e);
+    int take();
+    void worker();
+    bool runPooled();
+};
+
+/**
+ * Threads shared by all callbacks registered with the POOL executor. An executor with
+ * pending edges is queued once; a pool thread delivers what has been queued so far and
+ * puts the executor back at the end if more edges arrived meanwhile, so that callbacks
+ * take turns and no callback runs on two threads at once.
+ */
+class GPIOThreadPool {
+
+public:
+    static GPIOThreadPool& get();
+    ~GPIOThreadPool();
+
+    void schedule(GPIOCallbackExecutor* executor);
+
+private:
+    GPIOThreadPool();
+
+    std::deque<GPIOCallbackExecutor*> ready;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::vector<std::thread> threads;
+    bool running = true;
+
+    void worker();
+};
+
+#endif // GPIO_EXECUTOR_H
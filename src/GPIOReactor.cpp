@@ -0,0 +1,148 @@
+#include "GPIOReactor.h"
+#include "SafePrint.h" //safe printf in multi-threaded environment
+#include <cerrno>
+#include <cstring>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+GPIOReactor& GPIOReactor::get() {
+	static GPIOReactor reactor;
+	return reactor;
+}
+
+GPIOReactor::GPIOReactor() {
+	epollFd = epoll_create1(EPOLL_CLOEXEC);
+	wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (epollFd < 0 || wakeFd < 0) {
+		SafePrint::printf("[GPIOReactor::GPIOReactor()] : [ERROR] : epoll set could not be created: %s\n\r", strerror(errno));
+		return;
+	}
+	epoll_event ev = {};
+	ev.events = EPOLLIN;
+	ev.data.fd = wakeFd;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+}
+
+GPIOReactor::~GPIOReactor() {
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		running = false;
+	}
+	if (thr.joinable()) {
+		uint64_t one = 1;
+		if (write(wakeFd, &one, sizeof(one)) < 0) {
+			SafePrint::printf("[GPIOReactor::~GPIOReactor()] : [ERROR] : wakeup failed: %s\n\r", strerror(errno));
+		}
+		thr.join();
+	}
+	if (wakeFd >= 0) close(wakeFd);
+	if (epollFd >= 0) close(epollFd);
+}
+
+bool GPIOReactor::add(int fd, Handler* handler) {
+	std::lock_guard<std::mutex> lock(mtx);
+	if (epollFd < 0) return false;
+	if (failed) {
+		SafePrint::printf("[GPIOReactor::add()] : [ERROR] : fd %d not watched, the reactor thread has stopped\n\r", fd);
+		return false;
+	}
+	epoll_event ev = {};
+	ev.events = EPOLLIN | EPOLLPRI;
+	ev.data.fd = fd;
+	if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+		SafePrint::printf("[GPIOReactor::add()] : [ERROR] : fd %d could not be watched: %s\n\r", fd, strerror(errno));
+		return false;
+	}
+	handlers[fd] = handler;
+	if (!running) {
+		running = true;
+		thr = std::thread(&GPIOReactor::worker, this);
+	}
+	return true;
+}
+
+void GPIOReactor::remove(int fd) {
+	std::unique_lock<std::mutex> lock(mtx);
+	auto it = handlers.find(fd);
+	if (it == handlers.end()) return;
+	Handler* handler = it->second;
+	handlers.erase(it);
+	epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+	// the reactor thread may be running the handler right now, unless we are called from it
+	if (std::this_thread::get_id() != thr.get_id()) {
+		dispatch_cv.wait(lock, [this, handler]() { return dispatching != handler; });
+	}
+}
+
+void GPIOReactor::setThreadConfig(const ThreadConfig& config) {
+	std::unique_lock<std::mutex> lock(mtx);
+	threadConfig = config;
+	if (!running) return;
+	configPending = true;
+	uint64_t one = 1;
+	if (write(wakeFd, &one, sizeof(one)) < 0) {
+		SafePrint::printf("[GPIOReactor::setThreadConfig()] : [ERROR] : wakeup failed: %s\n\r", strerror(errno));
+		return;
+	}
+	if (std::this_thread::get_id() != thr.get_id()) {
+		dispatch_cv.wait(lock, [this]() { return !configPending; });
+	}
+}
+
+// called on the reactor thread
+void GPIOReactor::applyThreadConfig() {
+	std::unique_lock<std::mutex> lock(mtx);
+	ThreadConfig config = threadConfig;
+	configPending = false;
+	lock.unlock();
+	config.apply("gpio-reactor");
+	dispatch_cv.notify_all();
+}
+
+void GPIOReactor::worker() {
+	applyThreadConfig();
+	epoll_event events[MAX_EVENTS];
+	while (true) {
+		int n = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			SafePrint::printf("[GPIOReactor::worker()] : [ERROR] : epoll_wait failed: %s, no more GPIO events are dispatched\n\r", strerror(errno));
+			// no line is served any more: refuse new lines and release setThreadConfig()
+			std::unique_lock<std::mutex> lock(mtx);
+			running = false;
+			failed = true;
+			configPending = false;
+			lock.unlock();
+			dispatch_cv.notify_all();
+			return;
+		}
+		for (int i = 0; i < n; i++) {
+			int fd = events[i].data.fd;
+			std::unique_lock<std::mutex> lock(mtx);
+			if (!running) return;
+			if (fd == wakeFd) {
+				uint64_t count;
+				if (read(wakeFd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+					SafePrint::printf("[GPIOReactor::worker()] : [ERROR] : wakeup could not be reset: %s\n\r", strerror(errno));
+				}
+				bool pending = configPending;
+				lock.unlock();
+				if (pending) applyThreadConfig();
+				continue;
+			}
+			// a line removed after epoll_wait() returned is skipped
+			auto it = handlers.find(fd);
+			if (it == handlers.end()) continue;
+			Handler* handler = it->second;
+			dispatching = handler;
+			lock.unlock();
+			handler->onReadable(fd);
+			lock.lock();
+			dispatching = nullptr;
+			lock.unlock();
+			dispatch_cv.notify_all();
+		}
+	}
+}
@@ -0,0 +1,87 @@
+#ifndef GPIO_REACTOR_H
+#define GPIO_REACTOR_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include "ThreadConfig.h"
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+/**
+ * GPIOReactor waits for the events of all requested GPIO lines of the process in a single
+ * epoll set and dispatches them from one thread, so that monitoring more lines (door contacts,
+ * PIRs, sensor ALERTs) costs one file descriptor each instead of one thread each. Nothing
+ * wakes up while the lines are idle; the reactor thread itself is woken for shutdown
+ * through an eventfd.
+ *
+ * Handlers are called on the reactor thread and must hand long work to their own threads
+ * (see TMP117TemperatureSensor::hasEvent()), otherwise they delay the events of all other lines.
+ */
+class GPIOReactor {
+
+public:
+    struct Handler {
+	/**
+	 * Called on the reactor thread when fd has become readable.
+	 **/
+	virtual void onReadable(int fd) = 0;
+    };
+
+    // Returns the process-wide reactor, its thread is started on the first add().
+    static GPIOReactor& get();
+
+    ~GPIOReactor();
+
+    GPIOReactor(const GPIOReactor&) = delete;
+    GPIOReactor& operator=(const GPIOReactor&) = delete;
+
+    /**
+     * Starts watching fd (e.g. gpiod_line_event_get_fd()) for handler.
+     * \return false if fd could not be added to the epoll set, or the reactor thread has
+     * stopped on an error.
+     **/
+    bool add(int fd, Handler* handler);
+
+    /**
+     * Stops watching fd. When this returns, the handler of fd is not running and won't be
+     * called again, so fd can be closed. May be called from within the handler.
+     **/
+    void remove(int fd);
+
+    /**
+     * Real-time settings of the reactor thread. Applied when the thread starts; if it is
+     * already running the thread applies them before it dispatches the next event, and
+     * this call waits for that (unless called from a handler).
+     **/
+    void setThreadConfig(const ThreadConfig& config);
+
+private:
+    GPIOReactor();
+
+    static constexpr int MAX_EVENTS = 16; // events taken per epoll_wait()
+
+    int epollFd = -1;
+    int wakeFd = -1;   // eventfd to wake the reactor thread for shutdown
+    std::map<int, Handler*> handlers;
+    Handler* dispatching = nullptr; // handler running on the reactor thread
+    std::mutex mtx;
+    std::condition_variable dispatch_cv;
+    std::thread thr;
+    bool running = false;
+    bool failed = false;        // the reactor thread has stopped on an epoll error
+    ThreadConfig threadConfig;
+    bool configPending = false; // threadConfig changed while the thread was running
+
+    void worker();
+    void applyThreadConfig();
+};
+
+#endif // GPIO_REACTOR_H
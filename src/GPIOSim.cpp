@@ -0,0 +1,82 @@
+#include "GPIOSim.h"
+#include "SafePrint.h" //safe printf in multi-threaded environment
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define GPIO_SIM_CONFIGFS "/sys/kernel/config/gpio-sim/"
+#define GPIO_SIM_PLATFORM "/sys/devices/platform/"
+
+static bool writeFile(const std::string& path, const std::string& value) {
+	int fd = open(path.c_str(), O_WRONLY);
+	if (fd < 0) return false;
+	bool ok = write(fd, value.c_str(), value.size()) == (ssize_t)value.size();
+	close(fd);
+	return ok;
+}
+
+static std::string readFile(const std::string& path) {
+	char buf[64] = {};
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) return "";
+	ssize_t n = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	std::string s(buf, n > 0 ? n : 0);
+	while (!s.empty() && (s.back() == '\n' || s.back() == ' ')) s.pop_back();
+	return s;
+}
+
+GPIOSim::GPIOSim(int lines, const std::string& name) : configDir(GPIO_SIM_CONFIGFS + name) {
+	if (mkdir(configDir.c_str(), 0755) < 0) {
+		SafePrint::printf("[GPIOSim::GPIOSim()] : [ERROR] : %s could not be created: %s (gpio-sim loaded, configfs mounted, root?)\n\r",
+				  configDir.c_str(), strerror(errno));
+		return;
+	}
+	chipCreated = true;
+	if (mkdir((configDir + "/gpio-bank0").c_str(), 0755) < 0) {
+		SafePrint::printf("[GPIOSim::GPIOSim()] : [ERROR] : bank could not be created: %s\n\r", strerror(errno));
+		return;
+	}
+	bankCreated = true;
+	if (!writeFile(configDir + "/gpio-bank0/num_lines", std::to_string(lines)) ||
+	    !writeFile(configDir + "/live", "1")) {
+		SafePrint::printf("[GPIOSim::GPIOSim()] : [ERROR] : chip with %d lines could not be enabled: %s\n\r", lines, strerror(errno));
+		return;
+	}
+	enabled = true;
+
+	// e.g. gpio-sim.0 and gpiochip4
+	std::string device = readFile(configDir + "/dev_name");
+	std::string chip = readFile(configDir + "/gpio-bank0/chip_name");
+	if (chip.compare(0, 8, "gpiochip") == 0) chipNo = atoi(chip.c_str() + 8);
+	for (int i = 0; i < lines; i++) {
+		std::string pull = GPIO_SIM_PLATFORM + device + "/" + chip + "/sim_gpio" + std::to_string(i) + "/pull";
+		int fd = open(pull.c_str(), O_WRONLY | O_CLOEXEC);
+		if (fd < 0) {
+			SafePrint::printf("[GPIOSim::GPIOSim()] : [ERROR] : %s could not be opened: %s\n\r", pull.c_str(), strerror(errno));
+			return;
+		}
+		pullFds.push_back(fd);
+	}
+	live = true;
+	SafePrint::printf("[GPIOSim::GPIOSim()] : %s with %d lines on %s\n\r", name.c_str(), lines, chip.c_str());
+}
+
+GPIOSim::~GPIOSim() {
+	for (int fd : pullFds) close(fd);
+	if (enabled) writeFile(configDir + "/live", "0");
+	if (bankCreated) rmdir((configDir + "/gpio-bank0").c_str());
+	if (chipCreated) rmdir(configDir.c_str());
+}
+
+bool GPIOSim::setLevel(int offset, int level) {
+	if (offset < 0 || offset >= (int)pullFds.size()) return false;
+	static const char up[] = "pull-up";
+	static const char down[] = "pull-down";
+	const char* value = level ? up : down;
+	size_t len = level ? sizeof(up) - 1 : sizeof(down) - 1;
+	return pwrite(pullFds[offset], value, len, 0) == (ssize_t)len;
+}
@@ -0,0 +1,61 @@
+#ifndef GPIO_SIM_H
+#define GPIO_SIM_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include <string>
+#include <vector>
+
+/**
+ * GPIOSim creates a simulated GPIO chip with the kernel gpio-sim module, so that GPIOPin,
+ * Buzzer and everything behind them can run against real GPIO character devices and real
+ * kernel edge events on any Linux box. The chip is set up through configfs on construction
+ * and removed again by the destructor. Driving a line with setLevel() changes its pull, which
+ * the kernel reports to the requester of the line as an edge, with the kernel timestamp.
+ *
+ * Needs root, a kernel with CONFIG_GPIO_SIM ("modprobe gpio-sim") and configfs mounted on
+ * /sys/kernel/config.
+ */
+class GPIOSim {
+
+public:
+    /**
+     * \param lines Number of lines of the chip.
+     * \param name Name of the configfs entry, must be unique on the system.
+     **/
+    explicit GPIOSim(int lines, const std::string& name = "smart-system-sim");
+    ~GPIOSim();
+
+    GPIOSim(const GPIOSim&) = delete;
+    GPIOSim& operator=(const GPIOSim&) = delete;
+
+    // true if the chip has been created
+    bool isLive() const { return live; }
+
+    // N of /dev/gpiochipN, as passed to GPIOPin::start() and Buzzer
+    int getChipNumber() const { return chipNo; }
+    int getLines() const { return (int)pullFds.size(); }
+
+    /**
+     * Pulls line offset up (1) or down (0). Thread-safe, the lines can be driven concurrently.
+     * \return false if the pull could not be written.
+     **/
+    bool setLevel(int offset, int level);
+
+private:
+    std::string configDir;  // /sys/kernel/config/gpio-sim/<name>
+    std::vector<int> pullFds; // sysfs pull attribute of each line
+    int chipNo = -1;
+    bool live = false;
+    bool enabled = false;     // configfs live attribute set
+    bool bankCreated = false;
+    bool chipCreated = false;
+};
+
+#endif // GPIO_SIM_H
@@ -0,0 +1,291 @@
+#include "I2CBus.h"
+#include "SafePrint.h" //safe printf in multi-threaded environment
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <linux/i2c-dev.h>
+
+// reads are coalesced into one I2C_RDWR ioctl as long as their messages fit,
+// each register read needs two messages (pointer write + read)
+static_assert(2 * I2CBus::MAX_SEGMENTS <= I2C_RDWR_IOCTL_MAX_MSGS, "burst read does not fit into one transaction");
+
+std::mutex I2CBus::registry_mtx;
+std::map<int, std::unique_ptr<I2CBus>> I2CBus::registry;
+
+static int64_t monotonicNs() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+I2CBus& I2CBus::get(int busNo) {
+	std::lock_guard<std::mutex> lock(registry_mtx);
+	auto it = registry.find(busNo);
+	if (it == registry.end()) {
+		std::string path = "/dev/i2c-" + std::to_string(busNo);
+		it = registry.emplace(busNo, std::unique_ptr<I2CBus>(new I2CBus(path))).first;
+	}
+	return *it->second;
+}
+
+void I2CBus::printAllStats() {
+	std::lock_guard<std::mutex> lock(registry_mtx);
+	for (auto& bus : registry) {
+		bus.second->printStats();
+	}
+}
+
+I2CBus& I2CBus::attach(int busNo, std::unique_ptr<I2CTransport> transport) {
+	std::lock_guard<std::mutex> lock(registry_mtx);
+	auto it = registry.find(busNo);
+	if (it != registry.end()) {
+		SafePrint::printf("[I2CBus::attach()] : Error : bus %d is already in use by %s!\n\r", busNo, it->second->getDevicePath().c_str());
+		return *it->second;
+	}
+	return *registry.emplace(busNo, std::unique_ptr<I2CBus>(new I2CBus(std::move(transport)))).first->second;
+}
+
+I2CBus::I2CBus(const std::string& devicePath) : transport(new I2CDevTransport(devicePath)) {
+}
+
+I2CBus::I2CBus(std::unique_ptr<I2CTransport> transport) : transport(std::move(transport)) {
+}
+
+I2CBus::~I2CBus() {
+	stop();
+}
+
+bool I2CBus::timedTransfer(i2c_msg* msgs, int count) {
+	int64_t t0 = monotonicNs();
+	int r = transport->transfer(msgs, count);
+	nBusyNs += monotonicNs() - t0;
+	nTransfers++;
+	nMessages += count;
+	return r == count;
+}
+
+void I2CBus::submit(Request&& r) {
+	nRequests++;
+	uint32_t depth = ++nQueued;
+	uint32_t max = nMaxQueued.load();
+	while (depth > max && !nMaxQueued.compare_exchange_weak(max, depth)) {}
+
+	std::unique_lock<std::mutex> lock(queue_mtx);
+	if (!running) {
+		// the bus thread is started on first use so that derived classes are fully constructed
+		if (stopped) {
+			lock.unlock();
+			SafePrint::printf("[I2CBus::submit()] : Error : %s has been stopped!\n\r", getDevicePath().c_str());
+			nQueued--;
+			nErrors++;
+			r.done(false);
+			return;
+		}
+		running = true;
+		startedAtNs = monotonicNs();
+		thr = std::thread(&I2CBus::worker, this);
+	}
+	queue.push_back(std::move(r));
+	lock.unlock();
+	queue_cv.notify_one();
+}
+
+void I2CBus::readAsync(uint8_t addr, uint8_t reg, uint8_t* buf, size_t len, Completion done) {
+	ReadSegment segment = { reg, buf, len };
+	readAsync(addr, &segment, 1, std::move(done));
+}
+
+void I2CBus::readAsync(uint8_t addr, const ReadSegment* segments, int count, Completion done, bool clearsOnRead) {
+	if (count < 1 || count > MAX_SEGMENTS) {
+		SafePrint::printf("[I2CBus::readAsync()] : Error : %d segments requested, 1 - %d supported!\n\r", count, MAX_SEGMENTS);
+		nErrors++;
+		done(false);
+		return;
+	}
+	Request r;
+	r.addr = addr;
+	r.write = false;
+	r.clearsOnRead = clearsOnRead;
+	for (int i = 0; i < count; i++) r.segments[i] = segments[i];
+	r.nSegments = count;
+	r.done = std::move(done);
+	submit(std::move(r));
+}
+
+std::future<bool> I2CBus::readAsync(uint8_t addr, uint8_t reg, uint8_t* buf, size_t len) {
+	auto result = std::make_shared<std::promise<bool>>();
+	std::future<bool> f = result->get_future();
+	readAsync(addr, reg, buf, len, [result](bool ok) { result->set_value(ok); });
+	return f;
+}
+
+void I2CBus::writeAsync(uint8_t addr, uint8_t reg, const uint8_t* buf, size_t len, Completion done) {
+	Request r;
+	r.addr = addr;
+	r.write = true;
+	r.clearsOnRead = false;
+	r.nSegments = 0;
+	// pointer byte and data go out in one message, the device auto-increments from reg
+	r.data.reserve(1 + len);
+	r.data.push_back(reg);
+	r.data.insert(r.data.end(), buf, buf + len);
+	r.done = std::move(done);
+	submit(std::move(r));
+}
+
+bool I2CBus::readRegister(uint8_t addr, uint8_t reg, uint8_t* buf, size_t len, bool clearsOnRead) {
+	ReadSegment segment = { reg, buf, len };
+	return readRegisters(addr, &segment, 1, clearsOnRead);
+}
+
+bool I2CBus::readRegisters(uint8_t addr, const ReadSegment* segments, int count, bool clearsOnRead) {
+	auto result = std::make_shared<std::promise<bool>>();
+	std::future<bool> f = result->get_future();
+	readAsync(addr, segments, count, [result](bool ok) { result->set_value(ok); }, clearsOnRead);
+	return f.get();
+}
+
+bool I2CBus::writeRegister(uint8_t addr, uint8_t reg, const uint8_t* buf, size_t len) {
+	auto result = std::make_shared<std::promise<bool>>();
+	std::future<bool> f = result->get_future();
+	writeAsync(addr, reg, buf, len, [result](bool ok) { result->set_value(ok); });
+	return f.get();
+}
+
+/**
+ * Bus thread: takes everything that is queued, groups consecutive reads into one
+ * I2C_RDWR transaction and sends writes on their own, preserving the submission order.
+ */
+void I2CBus::worker() {
+	{
+		std::unique_lock<std::mutex> lock(queue_mtx);
+		ThreadConfig config = threadConfig;
+		lock.unlock();
+		config.apply("i2c-bus");
+	}
+	std::vector<Request> batch;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(queue_mtx);
+			queue_cv.wait(lock, [this]() { return !queue.empty() || !running; });
+			if (queue.empty()) break; // stopped and drained
+
+			batch.push_back(std::move(queue.front()));
+			queue.pop_front();
+			if (!batch.front().write) {
+				int messages = batch.front().messages();
+				while (!queue.empty() && !queue.front().write &&
+				       messages + queue.front().messages() <= I2C_RDWR_IOCTL_MAX_MSGS) {
+					messages += queue.front().messages();
+					batch.push_back(std::move(queue.front()));
+					queue.pop_front();
+				}
+			}
+		}
+		nQueued -= batch.size();
+		execute(batch);
+		batch.clear();
+	}
+}
+
+void I2CBus::execute(std::vector<Request>& batch) {
+	i2c_msg msgs[I2C_RDWR_IOCTL_MAX_MSGS];
+	int n = 0;
+	for (auto& r : batch) {
+		if (r.write) {
+			msgs[n].addr = r.addr;
+			msgs[n].flags = 0;
+			msgs[n].len = r.data.size();
+			msgs[n].buf = r.data.data();
+			n++;
+		} else {
+			for (int i = 0; i < r.nSegments; i++) {
+				ReadSegment& seg = r.segments[i];
+				// message 1: write the register pointer
+				msgs[n].addr = r.addr;
+				msgs[n].flags = 0;
+				msgs[n].len = 1;
+				msgs[n].buf = &seg.reg;
+				n++;
+				// message 2: repeated start and read the register content
+				msgs[n].addr = r.addr;
+				msgs[n].flags = I2C_M_RD;
+				msgs[n].len = seg.len;
+				msgs[n].buf = seg.buf;
+				n++;
+			}
+		}
+	}
+
+	if (timedTransfer(msgs, n)) {
+		if (batch.size() > 1) nCoalesced += batch.size();
+		for (auto& r : batch) r.done(true);
+		return;
+	}
+
+	if (batch.size() == 1) {
+		Request& r = batch.front();
+		uint8_t reg = r.write ? r.data[0] : r.segments[0].reg;
+		SafePrint::printf("[I2CBus::execute()] : Error : %s of register 0x%02X at 0x%02X on %s failed! %s\n\r",
+				  r.write ? "Write" : "Read", reg, r.addr, getDevicePath().c_str(), strerror(errno));
+		nErrors++;
+		r.done(false);
+		return;
+	}
+
+	// one device in the combined transaction failed and the reads before it have run: retry
+	// each read on its own to isolate it, except the clear-on-read ones, whose flags may have
+	// been consumed already; their callers decide how to recover
+	int error = errno; // of the combined transfer, the retries overwrite errno
+	for (auto& r : batch) {
+		if (r.clearsOnRead) {
+			SafePrint::printf("[I2CBus::execute()] : Error : Read of register 0x%02X at 0x%02X on %s failed in a combined transaction! %s\n\r",
+					  r.segments[0].reg, r.addr, getDevicePath().c_str(), strerror(error));
+			nErrors++;
+			r.done(false);
+			continue;
+		}
+		std::vector<Request> single;
+		single.push_back(std::move(r));
+		execute(single);
+	}
+}
+
+void I2CBus::stop() {
+	{
+		std::lock_guard<std::mutex> lock(queue_mtx);
+		if (!running) return;
+		running = false;
+		stopped = true;
+	}
+	queue_cv.notify_one();
+	thr.join(); //wait for the queue to be served
+}
+
+void I2CBus::setThreadConfig(const ThreadConfig& config) {
+	std::lock_guard<std::mutex> lock(queue_mtx);
+	threadConfig = config;
+}
+
+I2CBus::Stats I2CBus::getStats() const {
+	Stats s;
+	s.requests = nRequests;
+	s.transfers = nTransfers;
+	s.messages = nMessages;
+	s.coalesced = nCoalesced;
+	s.errors = nErrors;
+	s.busyNs = nBusyNs;
+	s.uptimeNs = startedAtNs ? monotonicNs() - startedAtNs : 0;
+	s.queueDepth = nQueued;
+	s.maxQueueDepth = nMaxQueued;
+	return s;
+}
+
+void I2CBus::printStats() const {
+	Stats s = getStats();
+	SafePrint::printf("[I2CBus] %s : requests %llu, transfers %llu, messages %llu, coalesced %llu, errors %llu, utilisation %.3f%%, queue %u (max %u)\n\r",
+			  getDevicePath().c_str(),
+			  (unsigned long long)s.requests, (unsigned long long)s.transfers,
+			  (unsigned long long)s.messages, (unsigned long long)s.coalesced,
+			  (unsigned long long)s.errors, s.utilisation() * 100.0,
+			  s.queueDepth, s.maxQueueDepth);
+}
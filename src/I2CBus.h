@@ -0,0 +1,192 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include "I2CTransport.h"
+#include "ThreadConfig.h"
+#include <linux/i2c.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * I2CBus class instance represents a long-lived session on one I2C adapter (/dev/i2c-N).
+ * Every register access is sent as a combined transaction (pointer write + repeated start
+ * + read) through an I2CTransport: the Linux i2c-dev device by default, or an in-process
+ * device model (see SimulatedTMP117.h).
+ *
+ * The bus is owned by one scheduler thread which serves a queue of transactions.
+ * Callers submit reads and writes and get the result through a future or a callback,
+ * so sensor threads never block each other on a bus lock. Reads that are queued
+ * together (e.g. several sensors becoming ready at the same time) are coalesced into
+ * a single I2C_RDWR ioctl with multiple messages.
+ */
+class I2CBus {
+
+public:
+    /**
+     * Returns the process-wide session for /dev/i2c-<busNo>, opening it on first use.
+     * \param busNo I2C adapter number. It's 1 on the Raspberry Pi header.
+     **/
+    static I2CBus& get(int busNo);
+
+    /**
+     * Registers a bus with the given transport as /dev/i2c-<busNo>, so that later get() calls
+     * (e.g. from SensorRegistry) use it instead of the i2c-dev device. Must be called before
+     * the first get() of that bus number.
+     * \return the registered bus, or the existing one if busNo is already in use.
+     **/
+    static I2CBus& attach(int busNo, std::unique_ptr<I2CTransport> transport);
+
+    /**
+     * Prints the counters of all buses opened through get().
+     **/
+    static void printAllStats();
+
+    // session on the i2c-dev device file devicePath, opened on first use
+    explicit I2CBus(const std::string& devicePath);
+    explicit I2CBus(std::unique_ptr<I2CTransport> transport);
+    ~I2CBus();
+
+    I2CBus(const I2CBus&) = delete;
+    I2CBus& operator=(const I2CBus&) = delete;
+
+    // called on the bus thread with the result of the transaction, must not block on the bus
+    using Completion = std::function<void(bool ok)>;
+
+    /**
+     * Queues a read of len bytes starting at register reg of the device at addr.
+     * buf must stay valid until done has been called.
+     **/
+    void readAsync(uint8_t addr, uint8_t reg, uint8_t* buf, size_t len, Completion done);
+    std::future<bool> readAsync(uint8_t addr, uint8_t reg, uint8_t* buf, size_t len);
+
+    // one register read within a burst, see readAsync(addr, segments, count, done)
+    struct ReadSegment {
+	uint8_t reg;
+	uint8_t* buf;
+	size_t len;
+    };
+    static constexpr int MAX_SEGMENTS = 4;
+
+    /**
+     * Queues reads of several registers of the device at addr that are sent back to back in
+     * one I2C_RDWR transaction (for devices whose register pointer does not auto-increment).
+     * The segments are never split over several transactions, so the values are consistent.
+     * \param count Number of segments, 1 to MAX_SEGMENTS.
+     * \param clearsOnRead The read changes the device state (e.g. status flags cleared on read).
+     * Such a read is combined with other reads like any other, but it is never sent a second
+     * time: if the combined transaction fails it fails as well, because it may already have run.
+     **/
+    void readAsync(uint8_t addr, const ReadSegment* segments, int count, Completion done, bool clearsOnRead = false);
+
+    /**
+     * Queues a write of len bytes to register reg of the device at addr. The data is copied.
+     **/
+    void writeAsync(uint8_t addr, uint8_t reg, const uint8_t* buf, size_t len, Completion done);
+
+    /**
+     * Reads len bytes starting at register reg of the device at addr and waits for the result.
+     * \return true on success, false if the bus could not be opened or the transfer failed.
+     **/
+    bool readRegister(uint8_t addr, uint8_t reg, uint8_t* buf, size_t len, bool clearsOnRead = false);
+
+    /**
+     * Reads several registers of the device at addr in one transaction and waits for the result.
+     * \return true on success, false if the bus could not be opened or the transfer failed.
+     **/
+    bool readRegisters(uint8_t addr, const ReadSegment* segments, int count, bool clearsOnRead = false);
+
+    /**
+     * Writes len bytes to register reg of the device at addr (pointer byte followed by the data)
+     * and waits for the result.
+     * \return true on success, false if the bus could not be opened or the transfer failed.
+     **/
+    bool writeRegister(uint8_t addr, uint8_t reg, const uint8_t* buf, size_t len);
+
+    /**
+     * Bus counters, all cumulative since start except queueDepth.
+     **/
+    struct Stats {
+	uint64_t requests = 0;       // reads and writes submitted
+	uint64_t transfers = 0;      // I2C_RDWR ioctls issued
+	uint64_t messages = 0;       // i2c messages sent in these ioctls
+	uint64_t coalesced = 0;      // reads that shared an ioctl with another read
+	uint64_t errors = 0;         // failed requests
+	uint64_t busyNs = 0;         // time spent inside transfers
+	uint64_t uptimeNs = 0;       // time since the bus thread started
+	uint32_t queueDepth = 0;     // requests currently waiting
+	uint32_t maxQueueDepth = 0;  // high water mark of queueDepth
+	double utilisation() const { return uptimeNs ? (double)busyNs / uptimeNs : 0; }
+    };
+    Stats getStats() const;
+    void printStats() const;
+
+    const std::string& getDevicePath() const { return transport->getName(); }
+
+    /**
+     * Stops the bus thread after the queue has been served. Called by the destructor.
+     **/
+    void stop();
+
+    /**
+     * Real-time settings of the bus thread. The thread is started on first use, so set it
+     * before the first transfer.
+     **/
+    void setThreadConfig(const ThreadConfig& config);
+
+private:
+    struct Request {
+	uint8_t addr;
+	bool write;
+	bool clearsOnRead;              // see readAsync(), never retried after a combined transaction failed
+	ReadSegment segments[MAX_SEGMENTS]; // registers and destinations for reads
+	int nSegments;
+	std::vector<uint8_t> data;      // pointer byte + payload for writes
+	Completion done;
+	int messages() const { return write ? 1 : 2 * nSegments; }
+    };
+
+    std::unique_ptr<I2CTransport> transport;
+
+    // transaction queue served by the bus thread
+    std::deque<Request> queue;
+    std::mutex queue_mtx;
+    std::condition_variable queue_cv;
+    std::thread thr;
+    bool running = false;
+    bool stopped = false;
+    ThreadConfig threadConfig;
+    std::atomic<int64_t> startedAtNs{0};
+
+    // counters
+    std::atomic<uint64_t> nRequests{0}, nTransfers{0}, nMessages{0}, nCoalesced{0}, nErrors{0}, nBusyNs{0};
+    std::atomic<uint32_t> nQueued{0}, nMaxQueued{0};
+
+    void submit(Request&& r);
+    void worker();
+    void execute(std::vector<Request>& batch);
+    bool timedTransfer(i2c_msg* msgs, int count);
+
+    static std::mutex registry_mtx;
+    static std::map<int, std::unique_ptr<I2CBus>> registry;
+};
+
+#endif // I2C_BUS_H
@@ -0,0 +1,42 @@
+#include "I2CTransport.h"
+#include "SafePrint.h" //safe printf in multi-threaded environment
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/i2c-dev.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+I2CDevTransport::I2CDevTransport(const std::string& devicePath) : devicePath(devicePath) {
+}
+
+I2CDevTransport::~I2CDevTransport() {
+	if (fd >= 0) close(fd);
+}
+
+/**
+ * Opens the bus device file once. A failed open is retried on the next transfer so that
+ * a bus which appears late (e.g. dtoverlay loaded after start-up) is picked up.
+ */
+bool I2CDevTransport::ensureOpen() {
+	if (fd >= 0) return true;
+	fd = open(devicePath.c_str(), O_RDWR);
+	if (fd < 0) {
+		SafePrint::printf("[I2CDevTransport::ensureOpen()] : Error : Failed to open %s! %s\n\r", devicePath.c_str(), strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+int I2CDevTransport::transfer(i2c_msg* msgs, int count) {
+	if (!ensureOpen()) return -1;
+
+	/**
+	 * I2C_RDWR executes all messages back to back with a repeated start in between,
+	 * holding the adapter lock for the whole transaction.
+	 */
+	i2c_rdwr_ioctl_data data;
+	data.msgs = msgs;
+	data.nmsgs = count;
+	return ioctl(fd, I2C_RDWR, &data);
+}
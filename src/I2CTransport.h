@@ -0,0 +1,57 @@
+#ifndef I2C_TRANSPORT_H
+#define I2C_TRANSPORT_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include <linux/i2c.h>
+#include <string>
+
+/**
+ * I2CTransport executes combined I2C transactions for an I2CBus. The bus thread is the only
+ * caller, so implementations need no locking against concurrent transfers.
+ * Implementations: I2CDevTransport (Linux i2c-dev) and SimulatedTMP117Transport (in-process
+ * TMP117 model for running and benchmarking the read path without hardware).
+ */
+class I2CTransport {
+
+public:
+    virtual ~I2CTransport() = default;
+
+    /**
+     * Submits msgs as one combined transaction, each message with its own slave address.
+     * \return number of messages transferred, or -1 on error (errno set).
+     **/
+    virtual int transfer(i2c_msg* msgs, int count) = 0;
+
+    // device path or description used in log messages
+    virtual const std::string& getName() const = 0;
+};
+
+/**
+ * Transport on a Linux I2C adapter (/dev/i2c-N). The device file is opened once and kept
+ * open; every transaction is one I2C_RDWR ioctl (pointer write + repeated start + read),
+ * so no I2C_SLAVE ioctl and no sleep between the write and the read are needed.
+ */
+class I2CDevTransport : public I2CTransport {
+
+public:
+    explicit I2CDevTransport(const std::string& devicePath);
+    ~I2CDevTransport() override;
+
+    int transfer(i2c_msg* msgs, int count) override;
+    const std::string& getName() const override { return devicePath; }
+
+private:
+    std::string devicePath;
+    int fd = -1;
+
+    bool ensureOpen();
+};
+
+#endif // I2C_TRANSPORT_H
@@ -0,0 +1,75 @@
+#include "LatencyHistogram.h"
+#include "SafePrint.h" //safe printf in multi-threaded environment
+#include <cmath>
+
+static constexpr int LINEAR = 1 << LatencyHistogram::SUB_BUCKET_BITS;
+static constexpr int HALF = LINEAR / 2;
+
+int LatencyHistogram::bucketOf(uint64_t ns) {
+	if (ns < (uint64_t)LINEAR) return ns;
+	int msb = 63 - __builtin_clzll(ns);
+	int shift = msb - SUB_BUCKET_BITS + 1;      // >= 1
+	int sub = ns >> shift;                      // HALF .. LINEAR - 1
+	return LINEAR + (shift - 1) * HALF + (sub - HALF);
+}
+
+uint64_t LatencyHistogram::upperBound(int bucket) {
+	if (bucket < LINEAR) return bucket;
+	int shift = (bucket - LINEAR) / HALF + 1;
+	uint64_t sub = HALF + (bucket - LINEAR) % HALF;
+	return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(int64_t ns) {
+	uint64_t v = ns < 0 ? 0 : (uint64_t)ns;
+	if (v > MAX_NS) v = MAX_NS;
+	counts[bucketOf(v)].fetch_add(1, std::memory_order_relaxed);
+	total.fetch_add(1, std::memory_order_relaxed);
+	uint64_t max = maxNs.load(std::memory_order_relaxed);
+	while (v > max && !maxNs.compare_exchange_weak(max, v, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::add(const LatencyHistogram& other) {
+	for (int b = 0; b < BUCKETS; b++) {
+		uint64_t n = other.counts[b].load(std::memory_order_relaxed);
+		if (n) counts[b].fetch_add(n, std::memory_order_relaxed);
+	}
+	total.fetch_add(other.count(), std::memory_order_relaxed);
+	uint64_t v = other.max();
+	uint64_t max = maxNs.load(std::memory_order_relaxed);
+	while (v > max && !maxNs.compare_exchange_weak(max, v, std::memory_order_relaxed)) {}
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+	uint64_t n = count();
+	if (n == 0) return 0;
+	uint64_t target = (uint64_t)std::ceil(p * n);
+	if (target < 1) target = 1;
+	uint64_t seen = 0;
+	for (int b = 0; b < BUCKETS; b++) {
+		seen += counts[b].load(std::memory_order_relaxed);
+		if (seen >= target) {
+			// the bucket bound can lie above the largest value recorded
+			uint64_t bound = upperBound(b);
+			uint64_t m = max();
+			return bound < m ? bound : m;
+		}
+	}
+	return max(); // values recorded while we were reading
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary() const {
+	Summary s;
+	s.count = count();
+	s.p50 = percentile(0.5);
+	s.p99 = percentile(0.99);
+	s.p999 = percentile(0.999);
+	s.max = max();
+	return s;
+}
+
+void LatencyHistogram::print(const char* label) const {
+	Summary s = summary();
+	SafePrint::printf("%s : p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us (%llu)\n\r",
+			  label, s.p50 / 1e3, s.p99 / 1e3, s.p999 / 1e3, s.max / 1e3, (unsigned long long)s.count);
+}
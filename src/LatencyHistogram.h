@@ -0,0 +1,62 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * LatencyHistogram counts latencies in nanoseconds in log-linear buckets (as HdrHistogram
+ * does): exact below 32 ns, then 16 buckets per power of two, i.e. a resolution of about 6%
+ * from nanoseconds up to MAX_NS. Recording is a few relaxed atomic increments, so it can be
+ * done on the event path by any number of threads while another thread reads percentiles.
+ */
+class LatencyHistogram {
+
+public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr int MAX_BITS = 40;                  // largest tracked latency ~18 minutes
+    static constexpr uint64_t MAX_NS = (1ULL << MAX_BITS) - 1;
+    static constexpr int BUCKETS = (1 << SUB_BUCKET_BITS) + (MAX_BITS - SUB_BUCKET_BITS) * (1 << (SUB_BUCKET_BITS - 1));
+
+    // Records one latency, negative values count as 0, values above MAX_NS as MAX_NS.
+    void record(int64_t ns);
+
+    struct Summary {
+	uint64_t count = 0;
+	uint64_t p50 = 0, p99 = 0, p999 = 0, max = 0; // ns
+    };
+    Summary summary() const;
+
+    /**
+     * Latency below which the fraction p (0..1) of the recorded values lie, as the upper
+     * bound of its bucket. 0 if nothing has been recorded.
+     **/
+    uint64_t percentile(double p) const;
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t max() const { return maxNs.load(std::memory_order_relaxed); }
+
+    // Adds the values recorded by other, e.g. to summarise several lines.
+    void add(const LatencyHistogram& other);
+
+    // Prints "<label> : p50 .. us, p99 .. us, p99.9 .. us, max .. us (n)" with SafePrint.
+    void print(const char* label) const;
+
+private:
+    static int bucketOf(uint64_t ns);
+    static uint64_t upperBound(int bucket);
+
+    std::atomic<uint64_t> counts[BUCKETS] = {};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> maxNs{0};
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -1,23 +1,168 @@
 #include "MotionSensor.h"
 #include "SafePrint.h" //safe printf in multi-threaded environment
+#include "BinaryLog.h" //binary logging of the per-event messages
 #include "gpioevent.h"
+#include "TimestampService.h"
+#include <cerrno>
+#include <cstring>
 #include <memory>
 #include <iostream>
+#include <sys/timerfd.h>
 #include <unistd.h>
 
-MotionSensor::MotionSensor(Buzzer* buzzer){
-    this->buzzer = buzzer;
+#define NS_PER_MS 1000000LL
+
+MotionSensor::MotionSensor(AlarmManager* alarms, const std::string& name)
+    : alarms(alarms), name(name),
+      holdOffNs(std::chrono::duration_cast<std::chrono::nanoseconds>(HOLD_OFF).count()),
+      intervalNs(std::chrono::duration_cast<std::chrono::nanoseconds>(COUNT_INTERVAL).count()) {
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerFd < 0 || !GPIOReactor::get().add(timerFd, this)) {
+        SafePrint::printf("[MotionSensor::MotionSensor()] : [ERROR] : %s : hold-off timer could not be set up, the area is never reported vacated\n\r", name.c_str());
+    }
+    if (!alarms) return;
+    AlarmManager::SourceConfig source;
+    source.name = name;
+    source.sound = Buzzer::Pattern::beep(std::chrono::seconds(2), BUZZER_PRIORITY);
+    alarmSource = alarms->addSource(source);
 }
+
+MotionSensor::~MotionSensor() {
+    if (timerFd < 0) return;
+    GPIOReactor::get().remove(timerFd);
+    close(timerFd);
+}
+
+void MotionSensor::setHoldOff(std::chrono::milliseconds holdOff) {
+    std::lock_guard<std::mutex> lock(mtx);
+    holdOffNs = holdOff.count() * NS_PER_MS;
+}
+
+void MotionSensor::setCountInterval(std::chrono::milliseconds interval) {
+    std::lock_guard<std::mutex> lock(mtx);
+    intervalNs = interval.count() * NS_PER_MS;
+    intervalStartNs = 0;
+    intervalEvents = 0;
+}
+
+/**
+ * Runs on the GPIO callback thread; only updates the state machine, the buzzer is driven by
+ * the alarm manager and the end of an occupancy by the hold-off timer.
+ */
 void MotionSensor::hasEvent(gpiod_line_event& event) {
+    int64_t monoNs = TimestampService::toNs(event.ts);
+    std::lock_guard<std::mutex> lock(mtx);
     if (event.event_type == GPIOD_LINE_EVENT_RISING_EDGE) {
-        SafePrint::printf("Motion Detected!\n\r");
-        buzzer->on();
-        sleep(2);
-        buzzer->off();
-
+        countEvent(monoNs);
+        // a retrigger while ACTIVE means the falling edge was lost (merged), nothing to change
+        if (state != ACTIVE) change(ACTIVE, monoNs);
     } else if (event.event_type == GPIOD_LINE_EVENT_FALLING_EDGE) {
-        SafePrint::printf("Motion Ended or no motion\n\r");
+        if (state != ACTIVE) return; // rising edge lost, the area already counts as vacated
+        lastFallNs = monoNs;
+        change(HOLD, monoNs);
+        armTimer(monoNs + holdOffNs);
+    }
+}
+
+void MotionSensor::onReadable(int) {
+    uint64_t expirations;
+    if (read(timerFd, &expirations, sizeof(expirations)) != sizeof(expirations)) return;
+    int64_t now = TimestampService::monotonicNow();
+    std::lock_guard<std::mutex> lock(mtx);
+    // a motion since the timer was armed has moved the state on, or re-armed it for later
+    if (state != HOLD) return;
+    if (now < lastFallNs + holdOffNs) {
+        armTimer(lastFallNs + holdOffNs);
+        return;
+    }
+    change(IDLE, lastFallNs + holdOffNs);
+}
+
+// called with mtx held
+void MotionSensor::change(State to, int64_t monoNs) {
+    Transition t;
+    t.from = state;
+    t.to = to;
+    timespec ts = { (time_t)(monoNs / TimestampService::NS_PER_SEC), (long)(monoNs % TimestampService::NS_PER_SEC) };
+    t.timestampNs = TimestampService::get().fromMonotonic(ts);
+    t.dwellNs = 0;
+    state = to;
+
+    if (t.from == IDLE) {
+        occupiedSinceNs = monoNs;
+        stats.occupancies++;
+        SAFE_PRINTF("[MotionSensor::hasEvent()] : %s : Motion Detected! area occupied\n\r", name.c_str());
+        if (alarms) alarms->reportCondition(alarmSource, true, t.timestampNs);
+    } else if (to == IDLE) {
+        t.dwellNs = lastFallNs > occupiedSinceNs ? lastFallNs - occupiedSinceNs : 0;
+        stats.occupiedNs += t.dwellNs;
+        if (t.dwellNs > stats.longestDwellNs) stats.longestDwellNs = t.dwellNs;
+        SAFE_PRINTF("[MotionSensor::onReadable()] : %s : area vacated after %.1f s\n\r", name.c_str(), t.dwellNs / 1e9);
+        if (alarms) alarms->reportCondition(alarmSource, false, t.timestampNs);
+    }
+    if (onOccupancyChanged) onOccupancyChanged(t);
+}
+
+// called with mtx held
+void MotionSensor::countEvent(int64_t monoNs) {
+    stats.events++;
+    rollInterval(monoNs);
+    intervalEvents++;
+}
+
+// called with mtx held, closes the counting intervals that have ended before monoNs
+void MotionSensor::rollInterval(int64_t monoNs) {
+    if (intervalStartNs == 0) {
+        intervalStartNs = monoNs;
+        return;
+    }
+    if (monoNs < intervalStartNs + intervalNs) return;
+    int64_t elapsed = (monoNs - intervalStartNs) / intervalNs;
+    // intervals without any event in between counted 0
+    stats.lastIntervalEvents = elapsed == 1 ? intervalEvents : 0;
+    if (intervalEvents > stats.maxIntervalEvents) stats.maxIntervalEvents = intervalEvents;
+    intervalStartNs += elapsed * intervalNs;
+    intervalEvents = 0;
+}
+
+// called with mtx held
+void MotionSensor::armTimer(int64_t monoNs) {
+    if (timerFd < 0) return;
+    itimerspec spec = {};
+    spec.it_value.tv_sec = monoNs / TimestampService::NS_PER_SEC;
+    spec.it_value.tv_nsec = monoNs % TimestampService::NS_PER_SEC;
+    if (timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, nullptr) < 0) {
+        SafePrint::printf("[MotionSensor::armTimer()] : [ERROR] : %s : %s\n\r", name.c_str(), strerror(errno));
+    }
+}
+
+MotionSensor::State MotionSensor::getState() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return state;
+}
+
+MotionSensor::Stats MotionSensor::getStats() {
+    std::lock_guard<std::mutex> lock(mtx);
+    rollInterval(TimestampService::monotonicNow());
+    return stats;
+}
+
+void MotionSensor::printStats() {
+    Stats s = getStats();
+    SafePrint::printf("[MotionSensor] : %s : %s, motion events %llu, occupancies %llu, occupied %.1f s (longest %.1f s), "
+                      "events in the last interval %llu (max %llu)\n\r",
+                      name.c_str(), stateName(getState()), (unsigned long long)s.events, (unsigned long long)s.occupancies,
+                      s.occupiedNs / 1e9, s.longestDwellNs / 1e9,
+                      (unsigned long long)s.lastIntervalEvents, (unsigned long long)s.maxIntervalEvents);
+}
+
+const char* MotionSensor::stateName(State state) {
+    switch (state) {
+    case IDLE: return "idle";
+    case ACTIVE: return "active";
+    case HOLD: return "hold";
     }
+    return "?";
 }
 
 /*//For independent testing 
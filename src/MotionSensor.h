@@ -11,14 +11,114 @@
  */
 
 #include "gpioevent.h"
-#include "buzzer.h"
+#include "GPIOReactor.h"
+#include "AlarmManager.h"
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
 
-class MotionSensor : public GPIOPin::GPIOEventCallbackInterface {
+/**
+ * MotionSensor tracks the occupancy of the area watched by a PIR from the kernel timestamps
+ * of its edges:
+ *
+ *   IDLE --rising--> ACTIVE --falling--> HOLD --hold-off expired--> IDLE
+ *                      ^                   |
+ *                      +------rising-------+
+ *
+ * The area counts as occupied from the rising edge that leaves IDLE until the hold-off has
+ * passed after the last falling edge without a new motion, so that someone sitting still
+ * between two PIR pulses is not reported as leaving. Only these occupancy transitions are
+ * published: to the alarm manager (occupied = condition detected) and to onOccupancyChanged.
+ * The hold-off expiry is a timerfd on the GPIOReactor, nothing ever sleeps on the PIR line.
+ *
+ * Besides the state it keeps the dwell time of each occupancy (first rising to last falling
+ * edge) and counts the motion events (rising edges) per counting interval.
+ */
+class MotionSensor : public GPIOPin::GPIOEventCallbackInterface, public GPIOReactor::Handler {
 public:
-    MotionSensor(Buzzer* buzzer);
+    enum State {
+	IDLE,    // nobody there
+	ACTIVE,  // PIR output high
+	HOLD     // PIR output low, waiting for the hold-off before the area counts as vacated
+    };
+
+    struct Transition {
+	State from;
+	State to;
+	int64_t timestampNs; // wall clock time of the transition in ns since the epoch
+	int64_t dwellNs;     // HOLD -> IDLE: how long the area was occupied, 0 otherwise
+    };
+
+    struct Stats {
+	uint64_t events = 0;         // motion events (rising edges)
+	uint64_t occupancies = 0;    // IDLE -> ACTIVE transitions
+	int64_t occupiedNs = 0;      // total dwell time of the finished occupancies
+	int64_t longestDwellNs = 0;
+	uint64_t lastIntervalEvents = 0; // motion events in the last finished counting interval
+	uint64_t maxIntervalEvents = 0;  // most motion events in one counting interval
+    };
+
+    static constexpr std::chrono::seconds HOLD_OFF{30};
+    static constexpr std::chrono::seconds COUNT_INTERVAL{60};
+
+    /**
+     * \param alarms Alarm manager the motion alarm is raised on, may be nullptr.
+     * \param name Name of the alarm source in logs and listeners.
+     **/
+    MotionSensor(AlarmManager* alarms, const std::string& name = "PIR");
+    ~MotionSensor();
+
+    MotionSensor(const MotionSensor&) = delete;
+    MotionSensor& operator=(const MotionSensor&) = delete;
+
     void hasEvent(gpiod_line_event& event) override;
+
+    // Time without motion after the last falling edge before the area counts as vacated.
+    void setHoldOff(std::chrono::milliseconds holdOff);
+    // Length of the intervals the motion events are counted in.
+    void setCountInterval(std::chrono::milliseconds interval);
+
+    /**
+     * Called on every occupancy transition, in order, on the GPIO callback thread or the
+     * GPIOReactor thread (hold-off expiry). Must not call back into the sensor.
+     **/
+    std::function<void(const Transition&)> onOccupancyChanged;
+
+    State getState();
+    Stats getStats();
+    void printStats();
+    static const char* stateName(State state);
+
+    // source of this PIR on the alarm manager, -1 without one
+    int getAlarmSource() const { return alarmSource; }
+
+    // priority of the motion alarm on the shared buzzer
+    static constexpr int BUZZER_PRIORITY = 1;
+
+    // hold-off timer, called on the GPIOReactor thread
+    void onReadable(int fd) override;
+
 private:
-    Buzzer* buzzer;
+    AlarmManager* alarms;
+    int alarmSource = -1;
+    std::string name;
+
+    std::mutex mtx;
+    State state = IDLE;
+    int64_t holdOffNs;
+    int64_t intervalNs;
+    int64_t occupiedSinceNs = 0;  // monotonic time of the rising edge that left IDLE
+    int64_t lastFallNs = 0;       // monotonic time of the last falling edge
+    int64_t intervalStartNs = 0;  // monotonic start of the current counting interval
+    uint64_t intervalEvents = 0;
+    Stats stats;
+    int timerFd = -1;
+
+    void change(State to, int64_t monoNs);
+    void countEvent(int64_t monoNs);
+    void rollInterval(int64_t monoNs);
+    void armTimer(int64_t monoNs);
 };
 
 #endif // MOTION_SENSOR_H
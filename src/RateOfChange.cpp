@@ -0,0 +1,89 @@
+#include "RateOfChange.h"
+#include <cmath>
+
+RateOfChange::RateOfChange(std::chrono::milliseconds window) : window(window), rate(NAN) {
+}
+
+void RateOfChange::setWindow(std::chrono::milliseconds window) {
+	this->window = window;
+	reset();
+}
+
+void RateOfChange::reset() {
+	head = 0;
+	count = 0;
+	sinceRebase = 0;
+	st = sv = stt = stv = 0;
+	rate = NAN;
+}
+
+void RateOfChange::push(const Sample& s) {
+	if (count == ring.size()) {
+		// window not full yet, grow the ring keeping the samples in order
+		std::vector<Sample> grown;
+		grown.reserve(ring.empty() ? 16 : ring.size() * 2);
+		for (size_t i = 0; i < count; i++) grown.push_back(at(i));
+		grown.resize(grown.capacity());
+		ring.swap(grown);
+		head = 0;
+	}
+	ring[(head + count) % ring.size()] = s;
+	count++;
+}
+
+/**
+ * Moves the origin to the oldest sample and sums up the window from scratch: keeps t small
+ * so that the running sums don't lose precision, and drops the rounding errors accumulated by
+ * adding and removing samples. Done once per ring length of samples, O(1) per sample.
+ */
+void RateOfChange::rebase() {
+	double shift = at(0).t;
+	originNs += (int64_t)llround(shift * 1e9);
+	st = sv = stt = stv = 0;
+	for (size_t i = 0; i < count; i++) {
+		Sample& s = ring[(head + i) % ring.size()];
+		s.t -= shift;
+		st += s.t;
+		sv += s.v;
+		stt += s.t * s.t;
+		stv += s.t * s.v;
+	}
+	sinceRebase = 0;
+}
+
+double RateOfChange::add(int64_t timestampNs, double value) {
+	if (count > 0 && timestampNs < lastNs) reset();
+	if (count == 0) originNs = timestampNs;
+	lastNs = timestampNs;
+
+	Sample s;
+	s.t = (timestampNs - originNs) / 1e9;
+	s.v = value;
+	push(s);
+	st += s.t;
+	sv += s.v;
+	stt += s.t * s.t;
+	stv += s.t * s.v;
+
+	// samples that have left the window
+	double oldest = s.t - window.count() / 1e3;
+	while (count > 1 && at(0).t < oldest) {
+		const Sample& o = at(0);
+		st -= o.t;
+		sv -= o.v;
+		stt -= o.t * o.t;
+		stv -= o.t * o.v;
+		head = (head + 1) % ring.size();
+		count--;
+	}
+	if (++sinceRebase >= ring.size()) rebase();
+
+	rate = NAN;
+	double span = at(count - 1).t - at(0).t;
+	if (count < 2 || span < window.count() / 2e3) return rate;
+	double n = count;
+	double d = n * stt - st * st;
+	if (d <= 0) return rate;
+	rate = (n * stv - st * sv) / d * 60;
+	return rate;
+}
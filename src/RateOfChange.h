@@ -0,0 +1,65 @@
+#ifndef RATE_OF_CHANGE_H
+#define RATE_OF_CHANGE_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include <stdint.h>
+#include <chrono>
+#include <vector>
+
+/**
+ * RateOfChange estimates how fast a value changes, in units per minute, as the slope of the
+ * least squares line through the samples of a sliding time window. The sums of the fit are
+ * updated as samples enter and leave the window, so a sample costs O(1) whatever the sampling
+ * rate; the samples are kept in a ring that only grows while the window fills up.
+ * Not thread-safe.
+ */
+class RateOfChange {
+
+public:
+    explicit RateOfChange(std::chrono::milliseconds window = std::chrono::seconds(60));
+
+    // Changes the window length, the samples collected so far are dropped.
+    void setWindow(std::chrono::milliseconds window);
+    std::chrono::milliseconds getWindow() const { return window; }
+
+    /**
+     * Adds a sample and returns the rate over the window, NAN until the samples span at
+     * least half of the window. A timestamp before the last one (clock set back) starts over.
+     * \param timestampNs Time of the sample in ns.
+     **/
+    double add(int64_t timestampNs, double value);
+
+    // Rate returned by the last add().
+    double get() const { return rate; }
+
+    void reset();
+
+private:
+    struct Sample {
+	double t; // s since originNs
+	double v;
+    };
+
+    std::chrono::milliseconds window;
+    std::vector<Sample> ring;
+    size_t head = 0;  // oldest sample
+    size_t count = 0;
+    int64_t originNs = 0;
+    int64_t lastNs = 0;
+    size_t sinceRebase = 0;
+    double st = 0, sv = 0, stt = 0, stv = 0; // sums of t, v, t*t and t*v over the window
+    double rate;
+
+    const Sample& at(size_t i) const { return ring[(head + i) % ring.size()]; }
+    void push(const Sample& s);
+    void rebase();
+};
+
+#endif // RATE_OF_CHANGE_H
@@ -0,0 +1,65 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include <atomic>
+#include <stddef.h>
+
+/**
+ * Bounded lock-free queue for exactly one producer thread and one consumer thread.
+ * push() and pop() never block and never allocate, so the producer can be a GPIO event
+ * thread that must return to the next edge right away.
+ * Capacity must be a power of two.
+ */
+template <typename T, size_t Capacity>
+class SPSCQueue {
+
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // producer side. \return false if the queue is full
+    bool push(const T& item) {
+	size_t tail = tailIdx.load(std::memory_order_relaxed);
+	if (tail - headCache == Capacity) {
+	    headCache = headIdx.load(std::memory_order_acquire);
+	    if (tail - headCache == Capacity) return false;
+	}
+	items[tail & (Capacity - 1)] = item;
+	tailIdx.store(tail + 1, std::memory_order_release);
+	return true;
+    }
+
+    // consumer side. \return false if the queue is empty
+    bool pop(T& item) {
+	size_t head = headIdx.load(std::memory_order_relaxed);
+	if (head == tailCache) {
+	    tailCache = tailIdx.load(std::memory_order_acquire);
+	    if (head == tailCache) return false;
+	}
+	item = items[head & (Capacity - 1)];
+	headIdx.store(head + 1, std::memory_order_release);
+	return true;
+    }
+
+    // approximate when called concurrently with push() or pop()
+    bool empty() const {
+	return headIdx.load(std::memory_order_acquire) == tailIdx.load(std::memory_order_acquire);
+    }
+
+private:
+    // producer and consumer indices on separate cache lines to avoid false sharing
+    alignas(64) std::atomic<size_t> tailIdx{0};
+    size_t headCache = 0;  // producer's copy of headIdx
+    alignas(64) std::atomic<size_t> headIdx{0};
+    size_t tailCache = 0;  // consumer's copy of tailIdx
+    alignas(64) T items[Capacity];
+};
+
+#endif // SPSC_QUEUE_H
@@ -2,6 +2,8 @@
  * @about: 
  * SafePrint.h provides a simple, thread-safe wrapper around printf() for multi-threaded C++ programs.
  * It ensures that log messages from multiple threads do not interleave or overwrite each other on the console.
+ * The messages are queued without a lock and written by a background thread (AsyncLog.h), so that
+ * logging on the acquisition threads does not wait for the console.
  */
 
 #ifndef SAFE_PRINTF_H
@@ -15,28 +17,34 @@
  * the Free Software Foundation. See the file LICENSE.
  */
 
+#include "AsyncLog.h"
 #include <cstdio>
 #include <cstdarg>
-#include <mutex>
 
 namespace SafePrint {
 
-    // Shared mutex for all printf calls across threads
-    inline std::mutex& getMutex() {
-        static std::mutex print_mutex;
-        return print_mutex;
-    }
-
-    // Thread-safe printf function
+    // Thread-safe printf function, formats on the calling thread and returns without waiting for the output
+    __attribute__((format(printf, 1, 2)))
     inline void printf(const char* format, ...) {
-        std::lock_guard<std::mutex> lock(getMutex());
-
         va_list args;
         va_start(args, format);
-        vprintf(format, args);
+        AsyncLog::get().vprintf(format, args);
         va_end(args);
+    }
+
+    // Waits until the messages printed so far have been written.
+    inline void flush() {
+        AsyncLog::get().flush();
+    }
+
+    // Writes every message before printf() returns, e.g. while debugging a crash.
+    inline void setSynchronous(bool on) {
+        AsyncLog::get().setSynchronous(on);
+    }
 
-        fflush(stdout);  // Optional: ensure it flushes immediately
+    // Messages dropped because the log queue was full.
+    inline uint64_t droppedMessages() {
+        return AsyncLog::get().getDropped();
     }
 
 }
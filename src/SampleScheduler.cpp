@@ -0,0 +1,82 @@
+#include "SampleScheduler.h"
+#include "SafePrint.h" //safe printf in multi-threaded environment
+
+void SampleScheduler::add(TMP117TemperatureSensor* sensor, std::chrono::milliseconds period) {
+	std::lock_guard<std::mutex> lock(mtx);
+	Entry e;
+	e.sensor = sensor;
+	e.period = period;
+	e.due = Clock::now();
+	e.onDemand = true; // first sample right away
+	entries.push_back(e);
+	cv.notify_one();
+}
+
+bool SampleScheduler::requestNow(TMP117TemperatureSensor* sensor) {
+	std::lock_guard<std::mutex> lock(mtx);
+	bool found = false;
+	for (auto& e : entries) {
+		if (e.sensor != sensor) continue;
+		e.onDemand = true;
+		found = true;
+	}
+	cv.notify_one();
+	return found;
+}
+
+void SampleScheduler::start() {
+	std::lock_guard<std::mutex> lock(mtx);
+	if (running) return;
+	running = true;
+	thr = std::thread(&SampleScheduler::worker, this);
+}
+
+void SampleScheduler::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		if (!running) return;
+		running = false;
+	}
+	cv.notify_one();
+	thr.join();
+}
+
+void SampleScheduler::worker() {
+	std::unique_lock<std::mutex> lock(mtx);
+	while (running) {
+		// collect the sensors that are due and find the next deadline
+		Clock::time_point now = Clock::now();
+		Clock::time_point next = Clock::time_point::max();
+		std::vector<TMP117TemperatureSensor*> due;
+		for (auto& e : entries) {
+			bool periodic = e.period.count() > 0 && e.due <= now;
+			if (e.onDemand || periodic) {
+				due.push_back(e.sensor);
+				e.onDemand = false;
+				if (e.period.count() > 0) {
+					// keep the sampling grid, skipping periods that have been missed
+					do { e.due += e.period; } while (e.due <= now);
+				}
+			}
+			if (e.period.count() > 0 && e.due < next) next = e.due;
+		}
+
+		if (!due.empty()) {
+			// sample outside the lock, the bus transfers can take a while
+			lock.unlock();
+			for (auto* sensor : due) {
+				if (!sensor->sample()) {
+					SafePrint::printf("[SampleScheduler::worker()] : [ERROR] : Sensor {%d} could not be sampled\n\r", sensor->getSensorId());
+				}
+			}
+			lock.lock();
+			continue;
+		}
+
+		if (next == Clock::time_point::max()) {
+			cv.wait(lock);
+		} else {
+			cv.wait_until(lock, next);
+		}
+	}
+}
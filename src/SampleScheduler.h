@@ -0,0 +1,71 @@
+#ifndef SAMPLE_SCHEDULER_H
+#define SAMPLE_SCHEDULER_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include "TMP117TemperatureSensor.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * SampleScheduler samples TMP117 sensors that are not woken up by a Data_Ready interrupt
+ * every conversion, see TMP117TemperatureSensor::sample():
+ * - one-shot mode : triggers a conversion, the result is delivered through the Data_Ready
+ *   interrupt as in continuous mode and the sensor stays in shutdown mode in between.
+ * - alert/therm mode : the sensor compares against its limits on its own, the scheduler
+ *   provides the slow background poll for telemetry.
+ * Each sensor gets a period (e.g. one sample per minute on battery powered nodes) and can in
+ * addition be sampled on demand with requestNow() (the "sample" command of the ControlServer).
+ */
+class SampleScheduler {
+
+public:
+    ~SampleScheduler() {
+	stop();
+    }
+
+    /**
+     * Adds a sensor which is sampled every period. A period of zero means on demand only.
+     * The first conversion is triggered right after start().
+     **/
+    void add(TMP117TemperatureSensor* sensor, std::chrono::milliseconds period);
+
+    /**
+     * Triggers a conversion of sensor as soon as possible, e.g. from the "sample" command of
+     * the ControlServer.
+     * \return false if the sensor has not been added.
+     **/
+    bool requestNow(TMP117TemperatureSensor* sensor);
+
+    void start();
+    void stop();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+	TMP117TemperatureSensor* sensor;
+	std::chrono::milliseconds period;
+	Clock::time_point due;
+	bool onDemand;
+    };
+
+    std::vector<Entry> entries;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::thread thr;
+    bool running = false;
+
+    void worker();
+};
+
+#endif // SAMPLE_SCHEDULER_H
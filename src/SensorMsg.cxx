@@ -42,6 +42,10 @@ SensorMsg::SensorMsg()
     m_temperature = 0.0;
     // m_timestamp com.eprosima.idl.parser.typecode.StringTypeCode@27f723
     m_timestamp ="";
+    // m_timestamp_ns com.eprosima.idl.parser.typecode.PrimitiveTypeCode@4d95d2a2
+    m_timestamp_ns = 0;
+    // m_alarm com.eprosima.idl.parser.typecode.PrimitiveTypeCode@1b2c6ec2
+    m_alarm = 0;
 
 }
 
@@ -57,6 +61,8 @@ SensorMsg::SensorMsg(
     m_sensor_id = x.m_sensor_id;
     m_temperature = x.m_temperature;
     m_timestamp = x.m_timestamp;
+    m_timestamp_ns = x.m_timestamp_ns;
+    m_alarm = x.m_alarm;
 }
 
 SensorMsg::SensorMsg(
@@ -65,6 +71,8 @@ SensorMsg::SensorMsg(
     m_sensor_id = x.m_sensor_id;
     m_temperature = x.m_temperature;
     m_timestamp = std::move(x.m_timestamp);
+    m_timestamp_ns = x.m_timestamp_ns;
+    m_alarm = x.m_alarm;
 }
 
 SensorMsg& SensorMsg::operator =(
@@ -74,6 +82,8 @@ SensorMsg& SensorMsg::operator =(
     m_sensor_id = x.m_sensor_id;
     m_temperature = x.m_temperature;
     m_timestamp = x.m_timestamp;
+    m_timestamp_ns = x.m_timestamp_ns;
+    m_alarm = x.m_alarm;
 
     return *this;
 }
@@ -85,6 +95,8 @@ SensorMsg& SensorMsg::operator =(
     m_sensor_id = x.m_sensor_id;
     m_temperature = x.m_temperature;
     m_timestamp = std::move(x.m_timestamp);
+    m_timestamp_ns = x.m_timestamp_ns;
+    m_alarm = x.m_alarm;
 
     return *this;
 }
@@ -93,7 +105,7 @@ bool SensorMsg::operator ==(
         const SensorMsg& x) const
 {
 
-    return (m_sensor_id == x.m_sensor_id && m_temperature == x.m_temperature && m_timestamp == x.m_timestamp);
+    return (m_sensor_id == x.m_sensor_id && m_temperature == x.m_temperature && m_timestamp == x.m_timestamp && m_timestamp_ns == x.m_timestamp_ns && m_alarm == x.m_alarm);
 }
 
 bool SensorMsg::operator !=(
@@ -116,6 +128,10 @@ size_t SensorMsg::getMaxCdrSerializedSize(
 
     current_alignment += 4 + eprosima::fastcdr::Cdr::alignment(current_alignment, 4) + 255 + 1;
 
+    current_alignment += 8 + eprosima::fastcdr::Cdr::alignment(current_alignment, 8);
+
+    current_alignment += 4 + eprosima::fastcdr::Cdr::alignment(current_alignment, 4);
+
 
     return current_alignment - initial_alignment;
 }
@@ -136,6 +152,10 @@ size_t SensorMsg::getCdrSerializedSize(
 
     current_alignment += 4 + eprosima::fastcdr::Cdr::alignment(current_alignment, 4) + data.timestamp().size() + 1;
 
+    current_alignment += 8 + eprosima::fastcdr::Cdr::alignment(current_alignment, 8);
+
+    current_alignment += 4 + eprosima::fastcdr::Cdr::alignment(current_alignment, 4);
+
 
     return current_alignment - initial_alignment;
 }
@@ -147,6 +167,8 @@ void SensorMsg::serialize(
     scdr << m_sensor_id;
     scdr << m_temperature;
     scdr << m_timestamp.c_str();
+    scdr << m_timestamp_ns;
+    scdr << m_alarm;
 
 }
 
@@ -157,6 +179,8 @@ void SensorMsg::deserialize(
     dcdr >> m_sensor_id;
     dcdr >> m_temperature;
     dcdr >> m_timestamp;
+    dcdr >> m_timestamp_ns;
+    dcdr >> m_alarm;
 }
 
 /*!
@@ -253,6 +277,63 @@ std::string& SensorMsg::timestamp()
     return m_timestamp;
 }
 
+/*!
+ * @brief This function sets a value in member timestamp_ns
+ * @param _timestamp_ns New value for member timestamp_ns
+ */
+void SensorMsg::timestamp_ns(
+        uint64_t _timestamp_ns)
+{
+    m_timestamp_ns = _timestamp_ns;
+}
+
+/*!
+ * @brief This function returns the value of member timestamp_ns
+ * @return Value of member timestamp_ns
+ */
+uint64_t SensorMsg::timestamp_ns() const
+{
+    return m_timestamp_ns;
+}
+
+/*!
+ * @brief This function returns a reference to member timestamp_ns
+ * @return Reference to member timestamp_ns
+ */
+uint64_t& SensorMsg::timestamp_ns()
+{
+    return m_timestamp_ns;
+}
+
+/*!
+ * @brief This function sets a value in member alarm
+ * @param _alarm New value for member alarm
+ */
+void SensorMsg::alarm(
+        uint32_t _alarm)
+{
+    m_alarm = _alarm;
+}
+
+/*!
+ * @brief This function returns the value of member alarm
+ * @return Value of member alarm
+ */
+uint32_t SensorMsg::alarm() const
+{
+    return m_alarm;
+}
+
+/*!
+ * @brief This function returns a reference to member alarm
+ * @return Reference to member alarm
+ */
+uint32_t& SensorMsg::alarm()
+{
+    return m_alarm;
+}
+
+
 size_t SensorMsg::getKeyMaxCdrSerializedSize(
         size_t current_alignment)
 {
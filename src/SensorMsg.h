@@ -187,6 +187,44 @@ public:
      */
     eProsima_user_DllExport std::string& timestamp();
 
+    /*!
+     * @brief This function sets a value in member timestamp_ns
+     * @param _timestamp_ns New value for member timestamp_ns
+     */
+    eProsima_user_DllExport void timestamp_ns(
+            uint64_t _timestamp_ns);
+
+    /*!
+     * @brief This function returns the value of member timestamp_ns
+     * @return Value of member timestamp_ns
+     */
+    eProsima_user_DllExport uint64_t timestamp_ns() const;
+
+    /*!
+     * @brief This function returns a reference to member timestamp_ns
+     * @return Reference to member timestamp_ns
+     */
+    eProsima_user_DllExport uint64_t& timestamp_ns();
+
+    /*!
+     * @brief This function sets a value in member alarm
+     * @param _alarm New value for member alarm
+     */
+    eProsima_user_DllExport void alarm(
+            uint32_t _alarm);
+
+    /*!
+     * @brief This function returns the value of member alarm
+     * @return Value of member alarm
+     */
+    eProsima_user_DllExport uint32_t alarm() const;
+
+    /*!
+     * @brief This function returns a reference to member alarm
+     * @return Reference to member alarm
+     */
+    eProsima_user_DllExport uint32_t& alarm();
+
     /*!
      * @brief This function returns the maximum serialized size of an object
      * depending on the buffer alignment.
@@ -249,6 +287,8 @@ private:
     uint32_t m_sensor_id;
     double m_temperature;
     std::string m_timestamp;
+    uint64_t m_timestamp_ns;
+    uint32_t m_alarm;
 };
 
 #endif // _FAST_DDS_GENERATED_SENSORMSG_H_
\ No newline at end of file
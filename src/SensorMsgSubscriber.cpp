@@ -8,6 +8,7 @@
 #include <csignal>
 #include "window.h"
 #include "SensorMsgSubscriber.h"
+#include <map>
 #include <fastdds/dds/domain/DomainParticipantFactory.hpp>
  
  using namespace eprosima::fastdds::dds;
@@ -55,7 +56,11 @@
         */
         if (parent_ && parent_->onTemperatureRead)
         {
-            parent_->onTemperatureRead(msg.sensor_id(), msg.temperature());
+            parent_->onTemperatureRead(msg.sensor_id(), msg.temperature(), msg.timestamp_ns());
+        }
+        if (parent_ && parent_->onAlarmState)
+        {
+            parent_->onAlarmState(msg.sensor_id(), msg.alarm());
         }
      }
  }
@@ -145,24 +150,35 @@
 
 	QApplication app(argc, argv);
     
-    Window sensor1Window, sensor2Window;
-	sensor1Window.setWindowTitle("TMP117 Sensor 1 client");
-	sensor2Window.setWindowTitle("TMP117 Sensor 2 client");
-
-	// Position windows
-	sensor1Window.move(400, 100);     // Top window
-	sensor2Window.move(400, 500);     // Below the first window
+    /**
+     * One window per sensor id, created on the first message of that sensor so that
+     * the client follows whatever sensors the publisher has been configured with.
+     * Windows are only touched in the Qt main thread.
+     */
+    std::map<int, Window*> sensorWindows;
+    auto windowFor = [&](int sensor_id) {
+        auto it = sensorWindows.find(sensor_id);
+        if (it != sensorWindows.end()) return it->second;
+        int i = sensorWindows.size();
+        Window* window = new Window();
+        window->setWindowTitle(QString("TMP117 Sensor %1 client").arg(sensor_id));
+        window->move(400 + (i / 2) * 950, 100 + (i % 2) * 400);
+        window->show();
+        sensorWindows[sensor_id] = window;
+        return window;
+    };
 
-	sensor1Window.show();
-	sensor2Window.show();
+    msgSubscriber.onTemperatureRead = [&](int sensor_id, double temperature, int64_t timestampNs) {
+        QMetaObject::invokeMethod(&app, [&windowFor, sensor_id, temperature, timestampNs]() {
+            windowFor(sensor_id)->updateTemperature(temperature, timestampNs);
+        }, Qt::QueuedConnection);
+    };
 
-    msgSubscriber.onTemperatureRead = [&](int sensor_id, double temperature) {
-        if(sensor_id == 1)
-            QMetaObject::invokeMethod(&sensor1Window, "updateTemperature", Qt::QueuedConnection,
-                                    Q_ARG(double, temperature));
-        else 
-            QMetaObject::invokeMethod(&sensor2Window, "updateTemperature", Qt::QueuedConnection,
-                                    Q_ARG(double, temperature));
+    // the alarm as raised on the publisher, acknowledged there
+    msgSubscriber.onAlarmState = [&](int sensor_id, int alarm) {
+        QMetaObject::invokeMethod(&app, [&windowFor, sensor_id, alarm]() {
+            windowFor(sensor_id)->setAlarm(alarm, false, false);
+        }, Qt::QueuedConnection);
     };
 
     return app.exec();
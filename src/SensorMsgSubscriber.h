@@ -65,7 +65,10 @@ public:
     virtual ~SensorMsgSubscriber();
 
     bool init();
-    std::function<void(int, double)> onTemperatureRead;
+    // called with sensor id, temperature and the sample timestamp in ns since the epoch
+    std::function<void(int, double, int64_t)> onTemperatureRead;
+    // called with sensor id and the alarm condition of the sensor (AlarmManager::Condition)
+    std::function<void(int, int)> onAlarmState;
 };
 
 #endif // SENSOR_MSG_SUBSCRIBER_H
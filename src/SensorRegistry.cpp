@@ -0,0 +1,382 @@
+#include "SensorRegistry.h"
+#include "I2CBus.h"
+#include "GPIOExecutor.h"
+#include "GPIOReactor.h"
+#include "SafePrint.h" //safe printf in multi-threaded environment
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <thread>
+
+/**
+ * TMP117 I2C addresses selectable with the ADDR pin:
+ * 0x48 : ADDR to GND, 0x49 : ADDR to V+, 0x4A : ADDR to SDA, 0x4B : ADDR to SCL
+ * useful commands:
+ * "i2cdetect -l" : lists all I2C adapters
+ * "i2cdetect -y 1" : to see which devices are connected to a I2C bus 1 (i2c-1), which is a default I2C bus on Raspberry Pi 5.
+ */
+#define TMP117_ADDR_MIN 0x48
+#define TMP117_ADDR_MAX 0x4B
+// attempts to initialize a sensor at start, SENSOR_INIT_RETRY_MS apart
+#define SENSOR_INIT_ATTEMPTS 3
+#define SENSOR_INIT_RETRY_MS 100
+
+bool SensorRegistry::load(const std::string& path, bool explicitPath) {
+	std::ifstream file(path);
+	if (!file && explicitPath) {
+		SafePrint::printf("[SensorRegistry::load()] : [ERROR] : %s could not be opened.\n\r", path.c_str());
+		return false;
+	}
+	if (!file) {
+		SafePrint::printf("[SensorRegistry::load()] : %s not found, using the default sensor wiring.\n\r", path.c_str());
+		loadDefaults();
+		return true;
+	}
+
+	entries.clear();
+	realtime = RealtimeConfig();
+	controlPath = CONTROL_SOCKET_PATH;
+	binaryLogPath.clear();
+	binaryLogSize = BINARY_LOG_SIZE;
+	std::string line;
+	int lineNo = 0;
+	while (std::getline(file, line)) {
+		lineNo++;
+		std::string where = path + ":" + std::to_string(lineNo);
+
+		// strip comments
+		size_t hash = line.find('#');
+		if (hash != std::string::npos) line.erase(hash);
+
+		std::istringstream in(line);
+		std::string keyword;
+		if (!(in >> keyword)) continue; // blank line
+		if (keyword == "realtime") {
+			if (!parseRealtime(in, where)) return false;
+			continue;
+		}
+		if (keyword == "memlock") {
+			realtime.lockMemory = true;
+			continue;
+		}
+		if (keyword == "control") {
+			if (!(in >> controlPath)) {
+				SafePrint::printf("[SensorRegistry::load()] : [ERROR] : %s : control needs a socket path or off\n\r", where.c_str());
+				return false;
+			}
+			if (controlPath == "off") controlPath.clear();
+			continue;
+		}
+		if (keyword == "binlog") {
+			size_t mib = BINARY_LOG_SIZE >> 20;
+			if (!(in >> binaryLogPath) || (!(in >> mib) && !in.eof()) || mib == 0) {
+				SafePrint::printf("[SensorRegistry::load()] : [ERROR] : %s : binlog needs a file path and optionally a size in MiB\n\r", where.c_str());
+				return false;
+			}
+			binaryLogSize = mib << 20;
+			continue;
+		}
+		if (keyword != "sensor") {
+			SafePrint::printf("[SensorRegistry::load()] : [ERROR] : %s : unknown keyword '%s'\n\r", where.c_str(), keyword.c_str());
+			return false;
+		}
+
+		TMP117SensorConfig config;
+		config.busNo = -1;
+		config.address = 0;
+		config.gpioLine = -1;
+		config.gpioChip = 0;
+		config.lowThreshold = TMP117TemperatureSensor::LOW_THRESHOLD;
+		config.highThreshold = TMP117TemperatureSensor::HIGH_THRESHOLD;
+		config.alertPin = TMP117Registers::PIN_DATA_READY;
+		config.sampleInterval = 0;
+		config.hysteresis = TMP117TemperatureSensor::ALARM_HYSTERESIS;
+		config.holdTime = 0;
+		config.latching = false;
+		config.rearmTime = TMP117TemperatureSensor::ALARM_REARM.count();
+		config.rateLimit = 0;
+		config.rateWindow = TMP117TemperatureSensor::RATE_WINDOW.count();
+		if (!(in >> config.sensorId)) {
+			SafePrint::printf("[SensorRegistry::load()] : [ERROR] : %s : missing sensor id\n\r", where.c_str());
+			return false;
+		}
+
+		std::string token;
+		while (in >> token) {
+			size_t eq = token.find('=');
+			if (eq == std::string::npos) {
+				SafePrint::printf("[SensorRegistry::load()] : [ERROR] : %s : expected key=value, got '%s'\n\r", where.c_str(), token.c_str());
+				return false;
+			}
+			std::string key = token.substr(0, eq);
+			const char* value = token.c_str() + eq + 1;
+			char* end;
+			if (key == "mode") {
+				std::string mode(value);
+				if (mode == "continuous") config.conversion.mode = TMP117Registers::MODE_CONTINUOUS;
+				else if (mode == "shutdown") config.conversion.mode = TMP117Registers::MODE_SHUTDOWN;
+				else if (mode == "oneshot") config.conversion.mode = TMP117Registers::MODE_ONE_SHOT;
+				else {
+					SafePrint::printf("[SensorRegistry::load()] : [ERROR] : %s : mode must be continuous, shutdown or oneshot\n\r", where.c_str());
+					return false;
+				}
+				continue;
+			}
+			if (key == "alert") {
+				std::string pin(value);
+				if (pin == "dataready") config.alertPin = TMP117Registers::PIN_DATA_READY;
+				else if (pin == "alert") config.alertPin = TMP117Registers::PIN_ALERT;
+				else if (pin == "therm") config.alertPin = TMP117Registers::PIN_THERM;
+				else {
+					SafePrint::printf("[SensorRegistry::load()] : [ERROR] : %s : alert must be dataready, alert or therm\n\r", where.c_str());
+					return false;
+				}
+				continue;
+			}
+			if (key == "avg") {
+				int count = strtol(value, &end, 0);
+				if (count == 1) config.conversion.averaging = TMP117Registers::AVG_1;
+				else if (count == 8) config.conversion.averaging = TMP117Registers::AVG_8;
+				else if (count == 32) config.conversion.averaging = TMP117Registers::AVG_32;
+				else if (count == 64) config.conversion.averaging = TMP117Registers::AVG_64;
+				else end = (char*)value; // reported as invalid below
+			}
+			else if (key == "conv") {
+				long conv = strtol(value, &end, 0);
+				if (conv < 0 || conv > 7) end = (char*)value;
+				config.conversion.cycle = conv;
+			}
+			else if (key == "interval") config.sampleInterval = strtod(value, &end);
+			else if (key == "bus") config.busNo = strtol(value, &end, 0);
+			else if (key == "addr") {
+				// range checked before it is narrowed, add() checks for a TMP117 address
+				long addr = strtol(value, &end, 0);
+				if (addr < 0 || addr > 0x7F) end = (char*)value;
+				config.address = addr;
+			}
+			else if (key == "gpio") config.gpioLine = strtol(value, &end, 0);
+			else if (key == "chip") config.gpioChip = strtol(value, &end, 0);
+			else if (key == "low") config.lowThreshold = strtod(value, &end);
+			else if (key == "high") config.highThreshold = strtod(value, &end);
+			else if (key == "hyst") config.hysteresis = strtod(value, &end);
+			else if (key == "hold") config.holdTime = strtod(value, &end);
+			else if (key == "rearm") config.rearmTime = strtod(value, &end);
+			else if (key == "rate") config.rateLimit = strtod(value, &end);
+			else if (key == "ratewin") config.rateWindow = strtod(value, &end);
+			else if (key == "latch") {
+				long latch = strtol(value, &end, 0);
+				if (latch != 0 && latch != 1) end = (char*)value;
+				config.latching = latch;
+			}
+			else {
+				SafePrint::printf("[SensorRegistry::load()] : [ERROR] : %s : unknown key '%s'\n\r", where.c_str(), key.c_str());
+				return false;
+			}
+			if (end == value || *end != '\0') {
+				SafePrint::printf("[SensorRegistry::load()] : [ERROR] : %s : invalid value '%s' for '%s'\n\r", where.c_str(), value, key.c_str());
+				return false;
+			}
+		}
+
+		if (!add(config, where)) return false;
+	}
+
+	SafePrint::printf("[SensorRegistry::load()] : %zu sensor(s) configured from %s\n\r", entries.size(), path.c_str());
+	return true;
+}
+
+bool SensorRegistry::parseRealtime(std::istream& in, const std::string& where) {
+	std::string thread;
+	in >> thread;
+	ThreadConfig* config;
+	if (thread == "gpio") config = &realtime.gpio;
+	else if (thread == "callbacks") config = &realtime.callbacks;
+	else if (thread == "i2c") config = &realtime.i2c;
+	else if (thread == "sensor") config = &realtime.sensor;
+	else {
+		SafePrint::printf("[SensorRegistry::load()] : [ERROR] : %s : realtime thread must be gpio, callbacks, i2c or sensor\n\r", where.c_str());
+		return false;
+	}
+
+	std::string token;
+	while (in >> token) {
+		size_t eq = token.find('=');
+		if (eq == std::string::npos) {
+			SafePrint::printf("[SensorRegistry::load()] : [ERROR] : %s : expected key=value, got '%s'\n\r", where.c_str(), token.c_str());
+			return false;
+		}
+		std::string key = token.substr(0, eq);
+		const char* value = token.c_str() + eq + 1;
+		char* end;
+		if (key == "cpus") {
+			if (!config->parseCpus(value)) {
+				SafePrint::printf("[SensorRegistry::load()] : [ERROR] : %s : invalid CPU list '%s'\n\r", where.c_str(), value);
+				return false;
+			}
+			continue;
+		}
+		if (key == "priority") {
+			long priority = strtol(value, &end, 0);
+			if (priority < 0 || priority > 99) end = (char*)value;
+			config->priority = priority;
+		}
+		else if (key == "prefault") {
+			long kib = strtol(value, &end, 0);
+			if (kib < 0) end = (char*)value;
+			else if ((size_t)kib > ThreadConfig::MAX_PREFAULT_STACK / 1024) {
+				SafePrint::printf("[SensorRegistry::load()] : [ERROR] : %s : prefault must not exceed %zu KiB\n\r",
+						  where.c_str(), ThreadConfig::MAX_PREFAULT_STACK / 1024);
+				return false;
+			}
+			config->prefaultStack = kib * 1024;
+		}
+		else {
+			SafePrint::printf("[SensorRegistry::load()] : [ERROR] : %s : unknown key '%s'\n\r", where.c_str(), key.c_str());
+			return false;
+		}
+		if (end == value || *end != '\0') {
+			SafePrint::printf("[SensorRegistry::load()] : [ERROR] : %s : invalid value '%s' for '%s'\n\r", where.c_str(), value, key.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
+void SensorRegistry::loadDefaults() {
+	entries.clear();
+	TMP117Registers::ConversionSettings continuous;
+	add({ 1, 1, 0x48, 17, 0, TMP117TemperatureSensor::LOW_THRESHOLD, TMP117TemperatureSensor::HIGH_THRESHOLD, continuous, TMP117Registers::PIN_DATA_READY, 0,
+	      TMP117TemperatureSensor::ALARM_HYSTERESIS, 0, false, (double)TMP117TemperatureSensor::ALARM_REARM.count(),
+	      0, (double)TMP117TemperatureSensor::RATE_WINDOW.count() }, "default");
+	add({ 2, 1, 0x49, 27, 0, TMP117TemperatureSensor::LOW_THRESHOLD, TMP117TemperatureSensor::HIGH_THRESHOLD, continuous, TMP117Registers::PIN_DATA_READY, 0,
+	      TMP117TemperatureSensor::ALARM_HYSTERESIS, 0, false, (double)TMP117TemperatureSensor::ALARM_REARM.count(),
+	      0, (double)TMP117TemperatureSensor::RATE_WINDOW.count() }, "default");
+}
+
+bool SensorRegistry::add(const TMP117SensorConfig& config, const std::string& where) {
+	if (config.busNo < 0 || config.gpioLine < 0 || config.address == 0) {
+		SafePrint::printf("[SensorRegistry::add()] : [ERROR] : %s : sensor %d needs bus, addr and gpio\n\r", where.c_str(), config.sensorId);
+		return false;
+	}
+	if (config.address < TMP117_ADDR_MIN || config.address > TMP117_ADDR_MAX) {
+		SafePrint::printf("[SensorRegistry::add()] : [ERROR] : %s : address 0x%02X is not a TMP117 address (0x48 - 0x4B)\n\r", where.c_str(), config.address);
+		return false;
+	}
+	if (config.sampleInterval < 0) {
+		SafePrint::printf("[SensorRegistry::add()] : [ERROR] : %s : interval must not be negative\n\r", where.c_str());
+		return false;
+	}
+	if (config.hysteresis < 0 || config.holdTime < 0 || config.rearmTime < 0) {
+		SafePrint::printf("[SensorRegistry::add()] : [ERROR] : %s : hyst, hold and rearm must not be negative\n\r", where.c_str());
+		return false;
+	}
+	if (config.rateLimit < 0 || config.rateWindow <= 0) {
+		SafePrint::printf("[SensorRegistry::add()] : [ERROR] : %s : rate must not be negative and ratewin must be positive\n\r", where.c_str());
+		return false;
+	}
+	if (config.conversion.mode == TMP117Registers::MODE_ONE_SHOT && config.alertPin != TMP117Registers::PIN_DATA_READY) {
+		// the result of a one-shot conversion would only be read if it crossed a limit
+		SafePrint::printf("[SensorRegistry::add()] : [ERROR] : %s : mode=oneshot needs alert=dataready\n\r", where.c_str());
+		return false;
+	}
+	if (config.lowThreshold >= config.highThreshold) {
+		SafePrint::printf("[SensorRegistry::add()] : [ERROR] : %s : low threshold must be below high threshold\n\r", where.c_str());
+		return false;
+	}
+	for (auto& e : entries) {
+		const TMP117SensorConfig& other = e.config;
+		if (other.sensorId == config.sensorId ||
+		    (other.busNo == config.busNo && other.address == config.address) ||
+		    (other.gpioChip == config.gpioChip && other.gpioLine == config.gpioLine)) {
+			SafePrint::printf("[SensorRegistry::add()] : [ERROR] : %s : sensor %d clashes with sensor %d (id, bus address or gpio line)\n\r",
+					  where.c_str(), config.sensorId, other.sensorId);
+			return false;
+		}
+	}
+	Entry e;
+	e.config = config;
+	entries.push_back(std::move(e));
+	return true;
+}
+
+void SensorRegistry::create(AlarmManager* alarms, SensorMsgPublisher* pub) {
+	if (realtime.lockMemory) ThreadConfig::lockMemory();
+	GPIOReactor::get().setThreadConfig(realtime.gpio);
+	GPIOCallbackExecutor::setThreadConfig(realtime.callbacks);
+	for (auto& e : entries) {
+		// sensors on the same bus share the process-wide session of that bus
+		I2CBus& bus = I2CBus::get(e.config.busNo);
+		bus.setThreadConfig(realtime.i2c);
+		e.sensor.reset(new TMP117TemperatureSensor(e.config.sensorId, alarms, bus, e.config.address));
+		e.sensor->setThresholds(e.config.lowThreshold, e.config.highThreshold);
+		e.sensor->setAlarmPolicy(e.config.hysteresis, std::chrono::milliseconds((long)(e.config.holdTime * 1000)), e.config.latching,
+					 std::chrono::milliseconds((long)(e.config.rearmTime * 1000)));
+		e.sensor->setRateWindow(std::chrono::milliseconds((long)(e.config.rateWindow * 1000)));
+		e.sensor->setRateLimit(e.config.rateLimit);
+		e.sensor->setConversion(e.config.conversion);
+		e.sensor->setAlertPin(e.config.alertPin);
+		e.sensor->setSensorMsgPublisher(pub);
+		e.sensor->setThreadConfig(realtime.sensor);
+		e.pin.reset(new GPIOPin());
+	}
+}
+
+TMP117TemperatureSensor* SensorRegistry::findSensor(int sensorId) {
+	for (auto& e : entries) {
+		if (e.config.sensorId == sensorId) return e.sensor.get();
+	}
+	return nullptr;
+}
+
+void SensorRegistry::start() {
+	for (auto& e : entries) {
+		SafePrint::printf("[SensorRegistry::start()] : sensor %d : /dev/i2c-%d address 0x%02X, GPIO %d on chip %d, alert outside [%.2f, %.2f] °C (%s)\n\r",
+				  e.config.sensorId, e.config.busNo, e.config.address, e.config.gpioLine, e.config.gpioChip,
+				  e.config.lowThreshold, e.config.highThreshold, TMP117TemperatureSensor::alertPinName(e.config.alertPin));
+		// a bus error during the configuration would leave the sensor silent, retry it
+		bool initialized = false;
+		for (int attempt = 0; attempt < SENSOR_INIT_ATTEMPTS && !initialized; attempt++) {
+			if (attempt > 0) std::this_thread::sleep_for(std::chrono::milliseconds(SENSOR_INIT_RETRY_MS));
+			initialized = e.sensor->initialize();
+		}
+		if (!initialized) {
+			SafePrint::printf("[SensorRegistry::start()] : [ERROR] : sensor %d could not be initialized, it reports no samples\n\r", e.config.sensorId);
+		}
+		e.pin->registerCallback(e.sensor.get());
+		e.pin->start(e.config.gpioLine, e.config.gpioChip, "TMP117 Temperature Sensor");
+		std::chrono::milliseconds interval((long)(e.config.sampleInterval * 1000));
+		if (e.config.conversion.mode == TMP117Registers::MODE_ONE_SHOT) {
+			sampleScheduler.add(e.sensor.get(), interval);
+		} else if (e.config.alertPin != TMP117Registers::PIN_DATA_READY) {
+			// woken up only on limit crossings, poll slowly for telemetry (or on demand only)
+			sampleScheduler.add(e.sensor.get(), interval);
+		}
+	}
+
+	// Force a startup temperature read for all sensors
+	for (auto& e : entries) {
+		e.sensor->readAndPrintStartupTemperature();
+	}
+
+	sampleScheduler.start();
+}
+
+void SensorRegistry::stop() {
+	sampleScheduler.stop();
+	for (auto& e : entries) {
+		if (e.pin) e.pin->stop();
+		if (e.sensor) e.sensor->stop(); // handles the edges still queued
+	}
+}
+
+void SensorRegistry::printStats() const {
+	for (auto& e : entries) {
+		if (e.sensor) e.sensor->printReadStats();
+		if (e.pin) {
+			std::string name = "sensor " + std::to_string(e.config.sensorId);
+			e.pin->printStats(name.c_str());
+			e.pin->printLatency(name.c_str());
+		}
+	}
+}
@@ -0,0 +1,139 @@
+#ifndef SENSOR_REGISTRY_H
+#define SENSOR_REGISTRY_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include "TMP117TemperatureSensor.h"
+#include "SampleScheduler.h"
+#include "gpioevent.h"
+#include "AlarmManager.h"
+#include "SensorMsgPublisher.h"
+#include "ThreadConfig.h"
+#include <istream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Default sensor configuration file, see sensors.conf for the format
+#define SENSOR_CONFIG_FILE "sensors.conf"
+// Default path of the control socket, see ControlServer.h
+#define CONTROL_SOCKET_PATH "/tmp/smart_system.sock"
+// Default size of the binary log file in bytes
+#define BINARY_LOG_SIZE (64UL << 20)
+
+/**
+ * Wiring of one TMP117 sensor as listed in the sensor configuration file.
+ */
+struct TMP117SensorConfig {
+    int sensorId;          // unique id used in logs, GUI and published messages
+    int busNo;             // I2C adapter number, /dev/i2c-<busNo>
+    uint8_t address;       // I2C address, 0x48 - 0x4B depending on the ADDR pin
+    int gpioLine;          // GPIO line connected to the ALERT (data ready) pin
+    int gpioChip;          // GPIO chip number of that line
+    double lowThreshold;   // alert below this temperature (°C)
+    double highThreshold;  // alert above this temperature (°C)
+    TMP117Registers::ConversionSettings conversion; // mode, conversion cycle and averaging
+    TMP117Registers::AlertPin alertPin; // data ready, or on-chip limit check in alert/therm mode
+    double sampleInterval; // seconds between one-shot conversions or telemetry polls, 0 = on demand only
+    double hysteresis;     // °C back inside a limit before the alarm clears
+    double holdTime;       // seconds a limit must stay crossed before the alarm is raised
+    bool latching;         // alarm stays raised until acknowledged
+    double rearmTime;      // seconds before the alarm can be raised again after a raise
+    double rateLimit;      // rate of change alarm above this rise in °C/min, 0 = off
+    double rateWindow;     // seconds the rate of change is fitted over
+};
+
+/**
+ * Real-time settings of the acquisition threads as listed in the sensor configuration file.
+ */
+struct RealtimeConfig {
+    ThreadConfig gpio;      // GPIOReactor thread, reads the edges of all lines
+    ThreadConfig callbacks; // GPIO callback executor threads
+    ThreadConfig i2c;       // I2C bus threads
+    ThreadConfig sensor;    // sensor processing threads
+    bool lockMemory = false;
+};
+
+/**
+ * SensorRegistry instantiates any number of TMP117TemperatureSensor objects from the sensor
+ * configuration file, each with its own GPIOPin for the data ready interrupt. Sensors on the
+ * same I2C bus share one I2CBus session; different buses are served by their own bus thread
+ * and therefore run in parallel.
+ */
+class SensorRegistry {
+
+public:
+    /**
+     * Reads the sensor list from path. When the default file (SENSOR_CONFIG_FILE, not given
+     * explicitly) does not exist the two sensors of the reference wiring (0x48 on GPIO 17,
+     * 0x49 on GPIO 27, both on /dev/i2c-1) are used.
+     * \param explicitPath The path was given by the user, e.g. on the command line; it must exist.
+     * \return false if the file has a syntax error or an invalid/duplicate entry, or an
+     * explicit path does not exist.
+     **/
+    bool load(const std::string& path, bool explicitPath = false);
+
+    // the reference wiring, used when no configuration file is present
+    void loadDefaults();
+
+    /**
+     * Creates the sensor objects and applies the real-time settings: memory locking, and
+     * the thread settings used by the GPIO, I2C and sensor threads when they start. Callbacks such as onTemperatureRead can be set on
+     * the returned sensors between create() and start().
+     **/
+    void create(AlarmManager* alarms, SensorMsgPublisher* pub);
+
+    /**
+     * Initializes every sensor, starts listening on its data ready GPIO line and
+     * forces a startup read.
+     **/
+    void start();
+
+    // Stops listening on all GPIO lines and stops the sensor processing threads.
+    void stop();
+
+    // Prints the read path counters of all sensors.
+    void printStats() const;
+
+    // one-shot conversions and telemetry polls of sensors not sampled by Data_Ready
+    SampleScheduler& getSampleScheduler() { return sampleScheduler; }
+
+    const RealtimeConfig& getRealtimeConfig() const { return realtime; }
+
+    // path of the control socket, empty if it is switched off
+    const std::string& getControlPath() const { return controlPath; }
+
+    // file of the binary log (SAFE_PRINTF, see BinaryLog.h), empty for text logging
+    const std::string& getBinaryLogPath() const { return binaryLogPath; }
+    size_t getBinaryLogSize() const { return binaryLogSize; }
+
+    size_t size() const { return entries.size(); }
+    const TMP117SensorConfig& getConfig(size_t i) const { return entries[i].config; }
+    TMP117TemperatureSensor& getSensor(size_t i) { return *entries[i].sensor; }
+    // sensor with the given id, nullptr if there is none or create() has not been called
+    TMP117TemperatureSensor* findSensor(int sensorId);
+
+private:
+    struct Entry {
+	TMP117SensorConfig config;
+	std::unique_ptr<TMP117TemperatureSensor> sensor;
+	std::unique_ptr<GPIOPin> pin;
+    };
+    std::vector<Entry> entries;
+    SampleScheduler sampleScheduler;
+    RealtimeConfig realtime;
+    std::string controlPath = CONTROL_SOCKET_PATH;
+    std::string binaryLogPath;
+    size_t binaryLogSize = BINARY_LOG_SIZE;
+
+    bool add(const TMP117SensorConfig& config, const std::string& where);
+    bool parseRealtime(std::istream& in, const std::string& where);
+};
+
+#endif // SENSOR_REGISTRY_H
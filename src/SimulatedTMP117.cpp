@@ -0,0 +1,303 @@
+#include "SimulatedTMP117.h"
+#include "TMP117Registers.h"
+#include <cerrno>
+
+// power-up values of the registers, refer TMP117 Datasheet, section 7.6 Register Maps
+#define POWER_UP_CONFIGURATION 0x0220 // continuous conversion, 1 s cycle, 8 averages
+#define POWER_UP_THIGH 0x6000         // 192 °C
+#define POWER_UP_TLOW 0x8000          // -256 °C
+
+// each byte on the bus takes 9 clock cycles (8 data bits + acknowledge)
+#define I2C_CLOCKS_PER_BYTE 9
+
+SimulatedTMP117Transport::SimulatedTMP117Transport(double timeScale, const std::string& name)
+	: name(name), timeScale(timeScale), rng(std::random_device()()) {
+}
+
+SimulatedTMP117Transport::~SimulatedTMP117Transport() {
+	stop();
+}
+
+void SimulatedTMP117Transport::addDevice(uint8_t addr, const DeviceModel& model) {
+	std::lock_guard<std::mutex> lock(mtx);
+	Device& d = devices[addr];
+	d.model = model;
+	reset(d);
+	if (running) schedule(d, Clock::now());
+	cv.notify_one();
+}
+
+void SimulatedTMP117Transport::setTemperature(uint8_t addr, double celsius) {
+	std::lock_guard<std::mutex> lock(mtx);
+	auto it = devices.find(addr);
+	if (it != devices.end()) it->second.model.temperature = celsius;
+}
+
+void SimulatedTMP117Transport::setErrorRate(double probability) {
+	std::lock_guard<std::mutex> lock(mtx);
+	errorRate = probability;
+}
+
+void SimulatedTMP117Transport::setBusSpeed(uint32_t hz) {
+	std::lock_guard<std::mutex> lock(mtx);
+	busHz = hz;
+}
+
+void SimulatedTMP117Transport::setAlertCallback(AlertCallback cb) {
+	std::lock_guard<std::mutex> lock(mtx);
+	alertCallback = std::move(cb);
+}
+
+int SimulatedTMP117Transport::getAlertLevel(uint8_t addr) {
+	std::lock_guard<std::mutex> lock(mtx);
+	auto it = devices.find(addr);
+	return it != devices.end() ? it->second.alertLevel : -1;
+}
+
+SimulatedTMP117Transport::Stats SimulatedTMP117Transport::getStats() {
+	std::lock_guard<std::mutex> lock(mtx);
+	return stats;
+}
+
+void SimulatedTMP117Transport::start() {
+	std::lock_guard<std::mutex> lock(mtx);
+	if (running) return;
+	running = true;
+	startTime = Clock::now();
+	for (auto& d : devices) schedule(d.second, startTime);
+	thr = std::thread(&SimulatedTMP117Transport::worker, this);
+}
+
+void SimulatedTMP117Transport::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		if (!running) return;
+		running = false;
+	}
+	cv.notify_one();
+	thr.join();
+}
+
+/**
+ * Power-up state. The result register holds the model temperature right away so that
+ * reads return a plausible value before the first conversion.
+ */
+void SimulatedTMP117Transport::reset(Device& d) {
+	for (auto& r : d.regs) r = 0;
+	d.regs[TMP117Registers::TEMP_RESULT] = TMP117Registers::fromCelsius(d.model.temperature);
+	d.regs[TMP117Registers::CONFIGURATION] = POWER_UP_CONFIGURATION;
+	d.regs[TMP117Registers::THIGH_LIMIT] = POWER_UP_THIGH;
+	d.regs[TMP117Registers::TLOW_LIMIT] = POWER_UP_TLOW;
+	d.regs[TMP117Registers::DEVICE_ID] = TMP117Registers::DEVICE_ID_TMP117;
+	d.pointer = 0;
+	d.alertLevel = 1;
+	d.nextConversion = Clock::time_point::max();
+}
+
+SimulatedTMP117Transport::Clock::duration SimulatedTMP117Transport::scaled(uint32_t us) const {
+	return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>(us / timeScale));
+}
+
+// schedules the next conversion after a configuration change
+void SimulatedTMP117Transport::schedule(Device& d, Clock::time_point now) {
+	TMP117Registers::ConversionSettings s = TMP117Registers::decode(d.regs[TMP117Registers::CONFIGURATION]);
+	if (!running || s.mode == TMP117Registers::MODE_SHUTDOWN) {
+		d.nextConversion = Clock::time_point::max();
+	} else if (s.mode == TMP117Registers::MODE_ONE_SHOT) {
+		d.nextConversion = now + scaled(TMP117Registers::conversionTimeUs(s.averaging));
+	} else {
+		d.nextConversion = now + scaled(TMP117Registers::cycleTimeUs(s.cycle, s.averaging));
+	}
+}
+
+void SimulatedTMP117Transport::convert(uint8_t addr, Device& d, Clock::time_point when, std::vector<Edge>& edges) {
+	double seconds = std::chrono::duration<double>(when - startTime).count() * timeScale;
+	double t = d.model.profile ? d.model.profile(seconds) : d.model.temperature;
+	if (d.model.noise > 0) t += std::normal_distribution<double>(0, d.model.noise)(rng);
+	t += TMP117Registers::toCelsius(d.regs[TMP117Registers::TEMP_OFFSET]);
+	d.regs[TMP117Registers::TEMP_RESULT] = TMP117Registers::fromCelsius(t);
+
+	uint16_t& config = d.regs[TMP117Registers::CONFIGURATION];
+	stats.conversions++;
+	if (config & TMP117Registers::CFG_DATA_READY) stats.overwritten++;
+	config |= TMP117Registers::CFG_DATA_READY;
+
+	double high = TMP117Registers::toCelsius(d.regs[TMP117Registers::THIGH_LIMIT]);
+	double low = TMP117Registers::toCelsius(d.regs[TMP117Registers::TLOW_LIMIT]);
+	if (config & TMP117Registers::CFG_THERM_MODE) {
+		// therm mode: HIGH follows the temperature with TLOW as hysteresis
+		if (t > high) config |= TMP117Registers::CFG_HIGH_ALERT;
+		else if (t < low) config &= ~TMP117Registers::CFG_HIGH_ALERT;
+	} else {
+		// alert mode: the flags latch until the configuration register is read
+		if (t > high) config |= TMP117Registers::CFG_HIGH_ALERT;
+		if (t < low) config |= TMP117Registers::CFG_LOW_ALERT;
+	}
+
+	TMP117Registers::ConversionSettings s = TMP117Registers::decode(config);
+	if ((config >> TMP117Registers::CFG_MOD_SHIFT & 0x3) == TMP117Registers::MODE_ONE_SHOT) {
+		// back to shutdown after a one-shot conversion
+		config = (config & ~(0x3 << TMP117Registers::CFG_MOD_SHIFT)) | (TMP117Registers::MODE_SHUTDOWN << TMP117Registers::CFG_MOD_SHIFT);
+		d.nextConversion = Clock::time_point::max();
+	} else {
+		// keep the conversion grid
+		d.nextConversion += scaled(TMP117Registers::cycleTimeUs(s.cycle, s.averaging));
+	}
+	updateAlertPin(addr, d, when, edges);
+}
+
+/**
+ * The register pointer does not auto-increment: a longer read returns the same register again.
+ * Reading the result or the configuration clears Data_Ready; reading the configuration also
+ * clears the alert flags in alert mode.
+ */
+void SimulatedTMP117Transport::read(uint8_t addr, Device& d, uint8_t* buf, int len, std::vector<Edge>& edges) {
+	uint8_t reg = d.pointer & 0x0F;
+	uint16_t value = d.regs[reg];
+	for (int i = 0; i < len; i++) {
+		buf[i] = (i & 1) ? (value & 0xFF) : (value >> 8); // MSB first
+	}
+
+	uint16_t& config = d.regs[TMP117Registers::CONFIGURATION];
+	if (reg == TMP117Registers::TEMP_RESULT || reg == TMP117Registers::CONFIGURATION) {
+		config &= ~TMP117Registers::CFG_DATA_READY;
+	}
+	if (reg == TMP117Registers::CONFIGURATION && !(config & TMP117Registers::CFG_THERM_MODE)) {
+		config &= ~(TMP117Registers::CFG_HIGH_ALERT | TMP117Registers::CFG_LOW_ALERT);
+	}
+	updateAlertPin(addr, d, Clock::now(), edges);
+}
+
+void SimulatedTMP117Transport::write(Device& d, const uint8_t* buf, int len) {
+	if (len < 1) return;
+	d.pointer = buf[0];
+	if (len < 3) return; // pointer write only
+
+	uint8_t reg = d.pointer & 0x0F;
+	uint16_t value = (buf[1] << 8) | buf[2];
+	switch (reg) {
+		case TMP117Registers::TEMP_RESULT:
+		case TMP117Registers::DEVICE_ID:
+			break; // read only
+		case TMP117Registers::CONFIGURATION:
+			if (value & TMP117Registers::CFG_SOFT_RESET) {
+				reset(d);
+			} else {
+				uint16_t& config = d.regs[TMP117Registers::CONFIGURATION];
+				config = (config & ~TMP117Registers::CFG_WRITABLE_MASK) | (value & TMP117Registers::CFG_WRITABLE_MASK);
+			}
+			schedule(d, Clock::now());
+			break;
+		case TMP117Registers::EEPROM_UL:
+			// EEPROM programming completes instantly, busy is never reported
+			d.regs[reg] = value & TMP117Registers::EEPROM_UNLOCK;
+			break;
+		default:
+			d.regs[reg] = value;
+	}
+}
+
+void SimulatedTMP117Transport::updateAlertPin(uint8_t addr, Device& d, Clock::time_point when, std::vector<Edge>& edges) {
+	uint16_t config = d.regs[TMP117Registers::CONFIGURATION];
+	bool asserted;
+	if (config & TMP117Registers::CFG_DR_ALERT) {
+		asserted = config & TMP117Registers::CFG_DATA_READY;
+	} else if (config & TMP117Registers::CFG_THERM_MODE) {
+		asserted = config & TMP117Registers::CFG_HIGH_ALERT;
+	} else {
+		asserted = config & (TMP117Registers::CFG_HIGH_ALERT | TMP117Registers::CFG_LOW_ALERT);
+	}
+	int level = (config & TMP117Registers::CFG_POL) ? asserted : !asserted;
+	if (level == d.alertLevel) return;
+	d.alertLevel = level;
+	// steady_clock is CLOCK_MONOTONIC, the clock of GPIO line events
+	int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count();
+	edges.push_back({ addr, level, ns });
+}
+
+void SimulatedTMP117Transport::notify(const AlertCallback& cb, const std::vector<Edge>& edges) {
+	if (!cb) return;
+	for (auto& e : edges) cb(e.addr, e.level, e.monotonicNs);
+}
+
+int SimulatedTMP117Transport::transfer(i2c_msg* msgs, int count) {
+	std::vector<Edge> edges;
+	AlertCallback cb;
+	int result = count;
+	int error = 0;
+	uint64_t bytes = 0;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		stats.transfers++;
+		// an injected error hits a random message, the messages before it have run as on a real bus
+		int failAt = count;
+		if (errorRate > 0 && std::uniform_real_distribution<double>(0, 1)(rng) < errorRate) {
+			failAt = std::uniform_int_distribution<int>(0, count - 1)(rng);
+		}
+		for (int i = 0; i < count; i++) {
+			if (i == failAt) {
+				stats.injectedErrors++;
+				error = EREMOTEIO;
+				result = -1;
+				break;
+			}
+			auto it = devices.find(msgs[i].addr);
+			if (it == devices.end()) {
+				stats.nacks++;
+				error = ENXIO;
+				result = -1;
+				break;
+			}
+			bytes += 1 + msgs[i].len; // address byte + data
+			if (msgs[i].flags & I2C_M_RD) {
+				read(msgs[i].addr, it->second, msgs[i].buf, msgs[i].len, edges);
+			} else {
+				write(it->second, msgs[i].buf, msgs[i].len);
+				updateAlertPin(msgs[i].addr, it->second, Clock::now(), edges);
+			}
+		}
+		if (!edges.empty()) cb = alertCallback;
+	}
+	cv.notify_one(); // a configuration write may have moved the next conversion
+
+	if (busHz) {
+		std::this_thread::sleep_for(std::chrono::nanoseconds(bytes * I2C_CLOCKS_PER_BYTE * 1000000000ULL / busHz));
+	}
+	notify(cb, edges);
+	if (result < 0) errno = error; // after the callbacks, which may have changed it
+	return result;
+}
+
+/**
+ * Simulation thread: completes the conversions that are due, reports ALERT pin changes
+ * outside the lock and sleeps until the next conversion of any device.
+ */
+void SimulatedTMP117Transport::worker() {
+	std::unique_lock<std::mutex> lock(mtx);
+	std::vector<Edge> edges;
+	while (running) {
+		Clock::time_point now = Clock::now();
+		Clock::time_point next = Clock::time_point::max();
+		for (auto& d : devices) {
+			while (d.second.nextConversion <= now) {
+				convert(d.first, d.second, d.second.nextConversion, edges);
+			}
+			if (d.second.nextConversion < next) next = d.second.nextConversion;
+		}
+
+		if (!edges.empty()) {
+			AlertCallback cb = alertCallback;
+			lock.unlock();
+			notify(cb, edges);
+			edges.clear();
+			lock.lock();
+			continue;
+		}
+
+		if (next == Clock::time_point::max()) {
+			cv.wait(lock);
+		} else {
+			cv.wait_until(lock, next);
+		}
+	}
+}
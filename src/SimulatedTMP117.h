@@ -0,0 +1,134 @@
+#ifndef SIMULATED_TMP117_H
+#define SIMULATED_TMP117_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include "I2CTransport.h"
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+/**
+ * SimulatedTMP117Transport is an in-process I2C bus with any number of TMP117 register models
+ * attached, so that the read path from TMP117TemperatureSensor to the publisher can run and be
+ * benchmarked on any Linux box. Each device models:
+ * - the register file with a non auto-incrementing register pointer
+ * - conversions in continuous, shutdown and one-shot mode with the conversion cycle and
+ *   averaging timing of the configuration register, optionally accelerated by timeScale
+ * - the Data_Ready and HIGH/LOW alert flags and their clear-on-read behaviour
+ * - the ALERT pin in data ready, alert and therm mode, reported through the alert callback
+ * - a temperature profile with gaussian noise
+ * The bus can inject transaction errors and add the transfer time of a real bus.
+ */
+class SimulatedTMP117Transport : public I2CTransport {
+
+public:
+    struct DeviceModel {
+	double temperature = 23.4375;  // °C, used when there is no profile
+	double noise = 0;              // standard deviation of the result noise in °C
+	// temperature in °C over the simulated time in seconds, overrides temperature
+	std::function<double(double seconds)> profile;
+    };
+
+    /**
+     * Called on the simulation or bus thread when the ALERT pin of a device changes.
+     * \param level Pin level, 0 = asserted with the default active low polarity.
+     * \param monotonicNs CLOCK_MONOTONIC time of the change, as in a GPIO line event.
+     * Must not wait for a transaction on this transport (e.g. a blocking I2CBus read),
+     * hand the event to another thread as the GPIO event thread of a real pin would.
+     **/
+    using AlertCallback = std::function<void(uint8_t addr, int level, int64_t monotonicNs)>;
+
+    struct Stats {
+	uint64_t transfers = 0;      // transactions served
+	uint64_t injectedErrors = 0; // transactions failed by error injection
+	uint64_t nacks = 0;          // transactions to an address without device
+	uint64_t conversions = 0;    // conversions completed by all devices
+	uint64_t overwritten = 0;    // conversions completed while the previous one was unread
+    };
+
+    /**
+     * \param timeScale Speed-up of simulated time, e.g. 100 for conversion cycles 100 times shorter.
+     **/
+    explicit SimulatedTMP117Transport(double timeScale = 1.0, const std::string& name = "simulated TMP117 bus");
+    ~SimulatedTMP117Transport() override;
+
+    // attaches a device at addr with power-up register values
+    void addDevice(uint8_t addr, const DeviceModel& model);
+    void addDevice(uint8_t addr) { addDevice(addr, DeviceModel()); }
+    void setTemperature(uint8_t addr, double celsius);
+
+    // probability that a transaction fails with EREMOTEIO (no acknowledge) at a random message,
+    // the messages before it have run
+    void setErrorRate(double probability);
+
+    // adds the transfer time of a bus running at hz to every transaction, 0 = instantaneous
+    void setBusSpeed(uint32_t hz);
+
+    void setAlertCallback(AlertCallback cb);
+    int getAlertLevel(uint8_t addr);
+    Stats getStats();
+
+    // starts and stops the conversions of all devices
+    void start();
+    void stop();
+
+    int transfer(i2c_msg* msgs, int count) override;
+    const std::string& getName() const override { return name; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Device {
+	DeviceModel model;
+	uint16_t regs[16];
+	uint8_t pointer = 0;
+	Clock::time_point nextConversion = Clock::time_point::max();
+	int alertLevel = 1;
+    };
+
+    struct Edge {
+	uint8_t addr;
+	int level;
+	int64_t monotonicNs;
+    };
+
+    std::string name;
+    double timeScale;
+    double errorRate = 0;
+    uint32_t busHz = 0;
+    std::map<uint8_t, Device> devices;
+    std::mt19937 rng;
+    Clock::time_point startTime;
+    Stats stats;
+    AlertCallback alertCallback;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::thread thr;
+    bool running = false;
+
+    void reset(Device& d);
+    void schedule(Device& d, Clock::time_point now);
+    void convert(uint8_t addr, Device& d, Clock::time_point when, std::vector<Edge>& edges);
+    void read(uint8_t addr, Device& d, uint8_t* buf, int len, std::vector<Edge>& edges);
+    void write(Device& d, const uint8_t* buf, int len);
+    void updateAlertPin(uint8_t addr, Device& d, Clock::time_point when, std::vector<Edge>& edges);
+    void notify(const AlertCallback& cb, const std::vector<Edge>& edges);
+    Clock::duration scaled(uint32_t us) const;
+    void worker();
+};
+
+#endif // SIMULATED_TMP117_H
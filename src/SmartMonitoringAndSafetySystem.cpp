@@ -3,7 +3,7 @@
  * ABOUT: Smart Monitoring and Safety System software to monitor temperature sensor 
  * via blocking IO in an interrupt driven model and calling the event handler callback
  * functions for event notification.
- * INPUT: two TMP117 temperature sensors and a PIR motion sensor
+ * INPUT: TMP117 temperature sensors listed in sensors.conf and a PIR motion sensor
  * OUTPUT: 
  * (1) Console output on the terminal
  * (2) Trigger the buzzer beep 
@@ -33,18 +33,23 @@
  #include "gpioevent.h"
  #include "buzzer.h"
  #include "SafePrint.h" //safe printf in multi-threaded environment
+#include "BinaryLog.h"
  #include "TMP117TemperatureSensor.h"
+ #include "SensorRegistry.h"
+ #include "I2CBus.h"
  #include "SensorMsgPublisher.h"
  #include "MotionSensor.h"
+ #include "AlarmManager.h"
+ #include "ControlServer.h"
  #include <mutex>
+ #include <memory>
+ #include <vector>
+ #include <map>
  //For QT:
  #include <QApplication>
  #include <csignal>
  #include "window.h"
  
- // Mutex to protect the shared I2C bus in a multi-threaded environment
- static std::mutex i2c_mutex; 
- 
  //For QT safe exit:
  void handleSignal(int signal) {
 	 if (signal == SIGINT || signal == SIGTERM) {
@@ -74,61 +79,110 @@
  
  //QT Start
 	 QApplication app(argc, argv);
-	 
-	 Window sensor1Window, sensor2Window;
-	 sensor1Window.setWindowTitle("TMP117 Sensor 1");
-	 sensor2Window.setWindowTitle("TMP117 Sensor 2");
- 
-	 // Position windows
-	 sensor1Window.move(100, 100);     // Top window
-	 sensor2Window.move(100, 500);     // Below the first window
- 
-	 sensor1Window.show();
-	 sensor2Window.show();
  //QT End
 	 
 	 Buzzer shared_buzzer = Buzzer(0, 25); //initialize Buzzer at gpiochip0 on pin 25
+	 // one alarm state per sensor, raises and clears drive the buzzer and the GUI
+	 AlarmManager alarms(&shared_buzzer);
 	 
-	 GPIOPin gpiopin17, gpiopin27, gpiopin23;
-	 const int gpioPinNo17 = 17;
-	 const int gpioPinNo27 = 27;
+	 GPIOPin gpiopin23;
 	 const int gpioPinNo23 = 23;
  
-	 TMP117TemperatureSensor t1 = TMP117TemperatureSensor(1, &shared_buzzer);
 	 /**
-	  * Callback implementation using a lambda (inline) function. 
-	  * It connects non-Qt backend logic (t1, the TMP117 sensor) to a Qt GUI method (updateTemperature).
-	  * @QMetaObject::invokeMethod() ensures that the GUI update runs in the Qt main thread, which is 
-	  * thread-safe and essential when callback runs from a separate thread (main()).
+	  * TMP117 sensors: bus, address, data ready GPIO line and thresholds come from the
+	  * sensor configuration file (first command line argument, default sensors.conf).
 	  */
-	 t1.onTemperatureRead = [&](double t) {
-		 QMetaObject::invokeMethod(&sensor1Window, "updateTemperature", Qt::QueuedConnection,
-								   Q_ARG(double, t));
-	 };
-	 t1.setSensorMsgPublisher(&msgPublisher);
- 
-	 TMP117TemperatureSensor t2 = TMP117TemperatureSensor(2, &shared_buzzer);
-	 t2.onTemperatureRead = [&](double t) {
-		 QMetaObject::invokeMethod(&sensor2Window, "updateTemperature", Qt::QueuedConnection,
-								   Q_ARG(double, t));
-	 };
-	 t2.setSensorMsgPublisher(&msgPublisher);
+	 SensorRegistry sensors;
+	 bool explicitPath = app.arguments().size() > 1;
+	 QString configPath = explicitPath ? app.arguments().at(1) : SENSOR_CONFIG_FILE;
+	 if (!sensors.load(configPath.toStdString(), explicitPath)) {
+		 SafePrint::printf("Invalid sensor configuration %s\n\r", configPath.toStdString().c_str());
+		 return -1;
+	 }
+	 // before the sensors start, so that their hot paths log binary from the first sample
+	 if (!sensors.getBinaryLogPath().empty()) {
+		 BinaryLog::get().open(sensors.getBinaryLogPath(), sensors.getBinaryLogSize());
+	 }
+	 sensors.create(&alarms, &msgPublisher);
  
-	 t1.initialize();
-	 gpiopin17.registerCallback(&t1);
-	 gpiopin17.start(gpioPinNo17, 0, "TMP117 Temperature Sensor");
+ //QT Start
+	 // One window per sensor, two per column
+	 std::vector<std::unique_ptr<Window>> sensorWindows;
+	 std::map<int, Window*> alarmWindows; // by alarm source
+	 std::map<int, Window*> rateWindows;  // by rate of change alarm source
+	 std::map<int, Window*> windowsById;  // by sensor id
+	 for (size_t i = 0; i < sensors.size(); i++) {
+		 const TMP117SensorConfig& config = sensors.getConfig(i);
+		 Window* window = new Window();
+		 sensorWindows.emplace_back(window);
+		 window->setWindowTitle(QString("TMP117 Sensor %1").arg(config.sensorId));
+		 window->setThresholds(config.lowThreshold, config.highThreshold);
+		 window->move(100 + (i / 2) * 950, 100 + (i % 2) * 400);
+		 window->show();
+ 
+		 /**
+		  * Callback implementation using a lambda (inline) function. 
+		  * It connects non-Qt backend logic (the TMP117 sensor) to a Qt GUI method (updateTemperature).
+		  * @QMetaObject::invokeMethod() ensures that the GUI update runs in the Qt main thread, which is 
+		  * thread-safe and essential when callback runs from a separate thread (main()).
+		  */
+		 sensors.getSensor(i).onTemperatureRead = [window](double t, int64_t timestampNs) {
+			 QMetaObject::invokeMethod(window, "updateTemperature", Qt::QueuedConnection,
+									   Q_ARG(double, t), Q_ARG(qint64, timestampNs));
+		 };
+		 int source = sensors.getSensor(i).getAlarmSource();
+		 int rateSource = sensors.getSensor(i).getRateAlarmSource();
+		 window->onAcknowledge = [&alarms, source, rateSource]() {
+			 alarms.acknowledge(source);
+			 alarms.acknowledge(rateSource);
+		 };
+		 alarmWindows[source] = window;
+		 rateWindows[rateSource] = window;
+		 windowsById[config.sensorId] = window;
+	 }
+	 // alarm changes of the sensors shown in their windows, the listener runs on the reporting thread
+	 alarms.addListener([&alarmWindows, &rateWindows](const AlarmManager::Alarm& alarm) {
+		 auto it = alarmWindows.find(alarm.source);
+		 if (it != alarmWindows.end()) {
+			 QMetaObject::invokeMethod(it->second, "setAlarm", Qt::QueuedConnection,
+						   Q_ARG(int, alarm.condition), Q_ARG(bool, alarm.latched), Q_ARG(bool, alarm.acknowledged));
+		 }
+		 it = rateWindows.find(alarm.source);
+		 if (it != rateWindows.end()) {
+			 QMetaObject::invokeMethod(it->second, "setRateAlarm", Qt::QueuedConnection,
+						   Q_ARG(bool, alarm.condition != AlarmManager::NORMAL), Q_ARG(bool, alarm.acknowledged),
+						   Q_ARG(double, alarm.value));
+		 }
+	 });
+ //QT End
  
-	 t2.initialize();
-	 gpiopin27.registerCallback(&t2);
-	 gpiopin27.start(gpioPinNo27, 0, "TMP117 Temperature Sensor");
-	 
-	 // Force a startup temperature read for both sensors
-	 t1.readAndPrintStartupTemperature();
-	 t2.readAndPrintStartupTemperature();
+	 sensors.start();
+
+	 // thresholds and rate limits changed at runtime, without a restart
+	 ControlServer control(sensors, &alarms);
+	 control.onThresholdsChanged = [&windowsById](int sensorId, double low, double high) {
+		 auto it = windowsById.find(sensorId);
+		 if (it != windowsById.end()) it->second->setThresholds(low, high);
+	 };
+	 if (!sensors.getControlPath().empty()) control.start(sensors.getControlPath());
 	 
 	 //Motion Sensor
-	 MotionSensor motionSensor(&shared_buzzer);
-	 gpiopin23.registerCallback(&motionSensor);
+	 // occupancy of the room, vacated 30 s (MotionSensor::HOLD_OFF) after the last motion
+	 MotionSensor motionSensor(&alarms, "PIR");
+	 // off the GPIO reactor thread, only the latest PIR state is kept if the handler lags
+	 GPIOPin::CallbackOptions motionOptions;
+	 motionOptions.executor = GPIOPin::POOL;
+	 motionOptions.queueSize = 4;
+	 motionOptions.overflow = GPIOPin::MERGE_LATEST;
+	 gpiopin23.registerCallback(&motionSensor, motionOptions);
+	 gpiopin23.setBurstPolicy(GPIOPin::COALESCE_LATEST); // only the current PIR state matters
+	 gpiopin23.setDebounce(std::chrono::milliseconds(50)); // kernel debounce with libgpiod v2
+	 // the HC-SR501 chatters when it retriggers, the buzzer should sound once per motion
+	 GPIOEdgeFilter::Options motionFilter;
+	 motionFilter.minPulseWidth = std::chrono::milliseconds(100); // shorter pulses are interference
+	 motionFilter.holdOff = std::chrono::seconds(3);              // retriggers within 3 s are the same motion
+	 motionFilter.maxPulsesPerSecond = 0.1;                      // at most one alarm per 10 s
+	 gpiopin23.setFilter(motionFilter);
 	 gpiopin23.start(gpioPinNo23, 0, "PIR Motion Sensor");
 	 
 	 /**
@@ -140,8 +194,16 @@
  
 	 // shutdown with QT
 	 QObject::connect(&app, &QCoreApplication::aboutToQuit, [&]() {
-		 gpiopin17.stop();
-		 gpiopin27.stop();
+		 control.stop();
+		 sensors.stop();
+		 gpiopin23.stop();
+		 alarms.removeListeners(); // the windows go before the alarm manager
+		 sensors.printStats();
+		 gpiopin23.printStats("PIR");
+		 gpiopin23.printLatency("PIR");
+		 motionSensor.printStats();
+		 I2CBus::printAllStats();
+		 alarms.printStats();
 	 });
  
 	 //return 0;
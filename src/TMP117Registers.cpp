@@ -0,0 +1,171 @@
+#include "TMP117Registers.h"
+#include "SafePrint.h" //safe printf in multi-threaded environment
+#include <cmath>
+#include <unistd.h>
+
+#define EEPROM_POLL_INTERVAL_US 1000
+#define EEPROM_POLL_TIMEOUT_US 50000 // EEPROM programming takes ~7 ms according to the data sheet
+
+TMP117Registers::TMP117Registers(I2CBus& bus, uint8_t addr) : bus(bus), addr(addr) {
+}
+
+bool TMP117Registers::readWord(Register reg, uint16_t& value) {
+	uint8_t buf[2];
+	// reading the configuration clears its Data_Ready and alert flags
+	if (!bus.readRegister(addr, reg, buf, 2, reg == CONFIGURATION)) return false;
+	value = (buf[0] << 8) | buf[1]; // MSB first
+	return true;
+}
+
+bool TMP117Registers::writeWord(Register reg, uint16_t value) {
+	uint8_t buf[2] = { (uint8_t)(value >> 8), (uint8_t)(value & 0xFF) }; // MSB first
+	return bus.writeRegister(addr, reg, buf, 2);
+}
+
+bool TMP117Registers::readConfiguration(uint16_t& config) {
+	return readWord(CONFIGURATION, config);
+}
+
+bool TMP117Registers::writeConfiguration(uint16_t config) {
+	if (!writeWord(CONFIGURATION, config)) return false;
+
+	uint16_t readback;
+	if (!readConfiguration(readback)) return false;
+	if ((readback & CFG_WRITABLE_MASK) != (config & CFG_WRITABLE_MASK)) {
+		SafePrint::printf("[TMP117Registers::writeConfiguration() 0x%02X] : [ERROR] : Config readback 0x%04X does not match 0x%04X\n\r", addr, readback, config);
+		return false;
+	}
+	return true;
+}
+
+bool TMP117Registers::readTemperature(double& celsius) {
+	uint16_t raw;
+	if (!readWord(TEMP_RESULT, raw)) return false;
+	celsius = toCelsius(raw);
+	return true;
+}
+
+bool TMP117Registers::readStatusAndTemperature(uint16_t& config, double& celsius) {
+	// the register pointer does not auto-increment, so each register is its own segment
+	uint8_t cfg[2], temp[2];
+	I2CBus::ReadSegment segments[] = {
+		{ CONFIGURATION, cfg, 2 },
+		{ TEMP_RESULT, temp, 2 }
+	};
+	if (!bus.readRegisters(addr, segments, 2, true)) return false;
+	config = (cfg[0] << 8) | cfg[1]; // MSB first
+	celsius = toCelsius((temp[0] << 8) | temp[1]);
+	return true;
+}
+
+bool TMP117Registers::readHighLimit(double& celsius) {
+	uint16_t raw;
+	if (!readWord(THIGH_LIMIT, raw)) return false;
+	celsius = toCelsius(raw);
+	return true;
+}
+
+bool TMP117Registers::writeHighLimit(double celsius) {
+	return writeWord(THIGH_LIMIT, fromCelsius(celsius));
+}
+
+bool TMP117Registers::readLowLimit(double& celsius) {
+	uint16_t raw;
+	if (!readWord(TLOW_LIMIT, raw)) return false;
+	celsius = toCelsius(raw);
+	return true;
+}
+
+bool TMP117Registers::writeLowLimit(double celsius) {
+	return writeWord(TLOW_LIMIT, fromCelsius(celsius));
+}
+
+bool TMP117Registers::readOffset(double& celsius) {
+	uint16_t raw;
+	if (!readWord(TEMP_OFFSET, raw)) return false;
+	celsius = toCelsius(raw);
+	return true;
+}
+
+bool TMP117Registers::writeOffset(double celsius) {
+	return writeWord(TEMP_OFFSET, fromCelsius(celsius));
+}
+
+bool TMP117Registers::readDeviceId(uint16_t& id) {
+	if (!readWord(DEVICE_ID, id)) return false;
+	if ((id & DEVICE_ID_MASK) != DEVICE_ID_TMP117) {
+		SafePrint::printf("[TMP117Registers::readDeviceId() 0x%02X] : [ERROR] : Unexpected device ID 0x%04X\n\r", addr, id);
+		return false;
+	}
+	return true;
+}
+
+bool TMP117Registers::programEEPROM(Register reg, uint16_t value) {
+	if (!writeWord(EEPROM_UL, EEPROM_UNLOCK)) return false;
+
+	bool ok = writeWord(reg, value);
+	if (ok) {
+		// wait for the EEPROM write cycle to finish
+		uint16_t status = EEPROM_UL_BUSY;
+		int waited = 0;
+		while (ok && (status & EEPROM_UL_BUSY) && waited < EEPROM_POLL_TIMEOUT_US) {
+			usleep(EEPROM_POLL_INTERVAL_US);
+			waited += EEPROM_POLL_INTERVAL_US;
+			ok = readWord(EEPROM_UL, status);
+		}
+		if (ok && (status & EEPROM_UL_BUSY)) {
+			SafePrint::printf("[TMP117Registers::programEEPROM() 0x%02X] : [ERROR] : EEPROM still busy after %d us\n\r", addr, waited);
+			ok = false;
+		}
+	}
+
+	// always lock the EEPROM again, otherwise every later register write programs it
+	return writeWord(EEPROM_UL, 0) && ok;
+}
+
+uint16_t TMP117Registers::encode(const ConversionSettings& settings, AlertPin pin) {
+	uint16_t config = ((settings.mode & 0x3) << CFG_MOD_SHIFT) |
+			  ((settings.cycle & 0x7) << CFG_CONV_SHIFT) |
+			  ((settings.averaging & 0x3) << CFG_AVG_SHIFT);
+	if (pin == PIN_DATA_READY) config |= CFG_DR_ALERT;
+	if (pin == PIN_THERM) config |= CFG_THERM_MODE;
+	return config;
+}
+
+TMP117Registers::ConversionSettings TMP117Registers::decode(uint16_t config) {
+	ConversionSettings settings;
+	uint8_t mod = (config >> CFG_MOD_SHIFT) & 0x3;
+	settings.mode = (mod == 2) ? MODE_CONTINUOUS : (Mode)mod;
+	settings.cycle = (config >> CFG_CONV_SHIFT) & 0x7;
+	settings.averaging = (Averaging)((config >> CFG_AVG_SHIFT) & 0x3);
+	return settings;
+}
+
+/**
+ * Conversion cycle time in ms, TMP117 Datasheet Table 7-7.
+ * The cycle can never be shorter than the active conversion time of the averaging.
+ */
+static const uint32_t CYCLE_TIME_US[8] = { 15500, 125000, 250000, 500000, 1000000, 4000000, 8000000, 16000000 };
+static const uint32_t ACTIVE_TIME_US[4] = { 15500, 125000, 500000, 1000000 };
+static const int AVERAGING_COUNT[4] = { 1, 8, 32, 64 };
+
+int TMP117Registers::averagingCount(Averaging averaging) {
+	return AVERAGING_COUNT[averaging & 0x3];
+}
+
+uint32_t TMP117Registers::conversionTimeUs(Averaging averaging) {
+	return ACTIVE_TIME_US[averaging & 0x3];
+}
+
+uint32_t TMP117Registers::cycleTimeUs(uint8_t cycle, Averaging averaging) {
+	uint32_t cycle_us = CYCLE_TIME_US[cycle & 0x7];
+	uint32_t active_us = conversionTimeUs(averaging);
+	return cycle_us > active_us ? cycle_us : active_us;
+}
+
+uint16_t TMP117Registers::fromCelsius(double celsius) {
+	double lsb = std::round(celsius / RESOLUTION);
+	if (lsb > INT16_MAX) lsb = INT16_MAX;
+	if (lsb < INT16_MIN) lsb = INT16_MIN;
+	return (uint16_t)(int16_t)lsb;
+}
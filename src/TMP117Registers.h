@@ -0,0 +1,167 @@
+#ifndef TMP117_REGISTERS_H
+#define TMP117_REGISTERS_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include "I2CBus.h"
+#include <stdint.h>
+
+/**
+ * TMP117Registers class instance gives typed access to the register map of one TMP117
+ * on an I2CBus session. All registers are 16 bit, transferred MSB first.
+ * Refer TMP117 Datasheet, section 7.6 Register Maps.
+ */
+class TMP117Registers {
+
+public:
+    enum Register : uint8_t {
+	TEMP_RESULT = 0x00,   // signed temperature result, 7.8125 m°C per LSB
+	CONFIGURATION = 0x01, // flags, mode, conversion cycle, averaging, alert pin
+	THIGH_LIMIT = 0x02,   // high limit for the alert function
+	TLOW_LIMIT = 0x03,    // low limit for the alert function
+	EEPROM_UL = 0x04,     // EEPROM unlock and busy status
+	EEPROM1 = 0x05,       // general purpose EEPROM words
+	EEPROM2 = 0x06,
+	TEMP_OFFSET = 0x07,   // signed offset added to every conversion result
+	EEPROM3 = 0x08,
+	DEVICE_ID = 0x0F      // device revision and ID
+    };
+
+    // Configuration register bits
+    static constexpr uint16_t CFG_HIGH_ALERT = 1 << 15;   // read only, cleared on read
+    static constexpr uint16_t CFG_LOW_ALERT = 1 << 14;    // read only, cleared on read
+    static constexpr uint16_t CFG_DATA_READY = 1 << 13;   // read only, cleared on read
+    static constexpr uint16_t CFG_EEPROM_BUSY = 1 << 12;  // read only
+    static constexpr uint16_t CFG_THERM_MODE = 1 << 4;    // T/nA: therm mode instead of alert mode
+    static constexpr uint16_t CFG_POL = 1 << 3;           // ALERT pin active high
+    static constexpr uint16_t CFG_DR_ALERT = 1 << 2;      // ALERT pin reflects Data_Ready
+    static constexpr uint16_t CFG_SOFT_RESET = 1 << 1;    // self clearing
+    static constexpr uint16_t CFG_WRITABLE_MASK = 0x0FFC; // MOD, CONV, AVG, T/nA, POL, DR/Alert
+
+    static constexpr uint16_t CFG_MOD_SHIFT = 10;        // MOD[11:10] conversion mode
+    static constexpr uint16_t CFG_CONV_SHIFT = 7;        // CONV[9:7] conversion cycle
+    static constexpr uint16_t CFG_AVG_SHIFT = 5;         // AVG[6:5] conversion averaging
+
+    // Conversion mode, MOD[11:10] (10 is continuous conversion as well)
+    enum Mode : uint8_t {
+	MODE_CONTINUOUS = 0,  // convert every cycle, Data_Ready after each conversion
+	MODE_SHUTDOWN = 1,    // no conversions, lowest current
+	MODE_ONE_SHOT = 3     // one conversion then shutdown
+    };
+
+    // Number of conversions averaged per result, AVG[6:5]
+    enum Averaging : uint8_t {
+	AVG_1 = 0,
+	AVG_8 = 1,
+	AVG_32 = 2,
+	AVG_64 = 3
+    };
+
+    /**
+     * Function of the (active low) ALERT pin, DR/Alert[2] and T/nA[4]:
+     * PIN_DATA_READY : asserted after every conversion, the host checks the limits
+     * PIN_ALERT : asserted when a result is above THIGH or below TLOW, released when the
+     *             configuration register is read
+     * PIN_THERM : asserted when a result is above THIGH, released once it drops below
+     *             TLOW (TLOW is the hysteresis, there is no low temperature alert)
+     **/
+    enum AlertPin : uint8_t {
+	PIN_DATA_READY,
+	PIN_ALERT,
+	PIN_THERM
+    };
+
+    /**
+     * Conversion settings held in the configuration register.
+     * cycle is the CONV[9:7] index; the resulting cycle time also depends on the
+     * averaging, see cycleTimeUs().
+     **/
+    struct ConversionSettings {
+	Mode mode = MODE_CONTINUOUS;
+	uint8_t cycle = 4;           // 1 second
+	Averaging averaging = AVG_1;
+    };
+
+    // configuration word for the given settings and ALERT pin function
+    static uint16_t encode(const ConversionSettings& settings, AlertPin pin);
+    static ConversionSettings decode(uint16_t config);
+
+    // time between two results in continuous conversion mode
+    static uint32_t cycleTimeUs(uint8_t cycle, Averaging averaging);
+    // time from the start of a (one-shot) conversion to Data_Ready
+    static uint32_t conversionTimeUs(Averaging averaging);
+    static int averagingCount(Averaging averaging);
+
+    static constexpr uint16_t EEPROM_UNLOCK = 1 << 15;
+    static constexpr uint16_t EEPROM_UL_BUSY = 1 << 14;
+
+    static constexpr uint16_t DEVICE_ID_MASK = 0x0FFF;
+    static constexpr uint16_t DEVICE_ID_TMP117 = 0x0117;
+
+    // temperature, limit and offset resolution in °C per LSB
+    static constexpr double RESOLUTION = 0.0078125;
+
+    TMP117Registers(I2CBus& bus, uint8_t addr);
+
+    bool readWord(Register reg, uint16_t& value);
+    bool writeWord(Register reg, uint16_t value);
+
+    /**
+     * Reads the configuration register. Note: reading it clears the Data_Ready
+     * and HIGH/LOW alert flags.
+     **/
+    bool readConfiguration(uint16_t& config);
+
+    /**
+     * Writes the configuration register and reads it back to verify that all
+     * writable bits have been taken over by the device.
+     **/
+    bool writeConfiguration(uint16_t config);
+
+    bool readTemperature(double& celsius);
+
+    /**
+     * Reads the configuration register (Data_Ready and HIGH/LOW alert flags) followed by the
+     * temperature result in one bus transaction. The configuration is read first so that the
+     * result belongs to the conversion flagged by Data_Ready. Clears the flags like
+     * readConfiguration().
+     **/
+    bool readStatusAndTemperature(uint16_t& config, double& celsius);
+
+    bool readHighLimit(double& celsius);
+    bool writeHighLimit(double celsius);
+    bool readLowLimit(double& celsius);
+    bool writeLowLimit(double celsius);
+    bool readOffset(double& celsius);
+    bool writeOffset(double celsius);
+
+    /**
+     * Reads the device ID register and checks it against the TMP117 ID.
+     * \param id Raw register content (revision in bits 15-12).
+     **/
+    bool readDeviceId(uint16_t& id);
+
+    /**
+     * Programs reg (CONFIGURATION, limits, TEMP_OFFSET or EEPROM1-3) permanently:
+     * unlocks the EEPROM, writes the value, waits for EEPROM_Busy to clear (~7 ms)
+     * and locks the EEPROM again. Meant for commissioning, not for the data path.
+     **/
+    bool programEEPROM(Register reg, uint16_t value);
+
+    uint8_t getAddress() const { return addr; }
+
+    static double toCelsius(uint16_t raw) { return (int16_t)raw * RESOLUTION; }
+    static uint16_t fromCelsius(double celsius);
+
+private:
+    I2CBus& bus;
+    uint8_t addr;
+};
+
+#endif // TMP117_REGISTERS_H
@@ -1,18 +1,13 @@
 #include "TMP117TemperatureSensor.h"
 #include "SensorMsgPublisher.h"
 #include "SafePrint.h"
+#include "BinaryLog.h"
+#include "TimestampService.h"
 #include <chrono>
 #include <thread>
 #include <cmath>
 #include <cstring>
-#include <fcntl.h>
-#include <linux/i2c-dev.h>
-#include <sys/ioctl.h>
 #include <unistd.h>
-#include <cstdlib>
-
-// Mutex to protect the shared I2C bus in a multi-threaded environment
-static std::mutex i2c_mutex; 
 
 /**
  * GPIO_CHIP : Raspberry Pi 5 GPIO controller
@@ -22,28 +17,125 @@ static std::mutex i2c_mutex;
  */
 #define GPIO_CHIP "/dev/gpiochip0"
 /**
- * I2C_BUS : I2C bus on Raspberry Pi 5
- * useful commands:
- * "i2cdetect -l" : lists all I2C adapters
- * "i2cdetect -y 1" : to see which devices are connected to a I2C bus 1 (i2c-1), which is a default I2C bus on Raspberry Pi 5.
+ * Attempts of the status read after an ALERT edge. The edge is only generated once: if the
+ * read fails the flags stay set, the ALERT pin stays asserted and no further edge would follow.
  */
-#define I2C_BUS "/dev/i2c-1"
-
-#define TMP117_ADDR1 0x48	 //I2C address of TMP117 Sensor where ADDR Pin is connected to GND.
-#define TMP117_ADDR2 0x49    //I2C address of TMP117 Sensor where ADDR Pin is connected to VIN (3.3V).
+#define STATUS_READ_ATTEMPTS 3
+/**
+ * Data_Ready watchdog: when no new conversion has been read for this many conversion cycles
+ * (or conversion times after a one-shot trigger), the processing thread reads the status
+ * itself. This releases an ALERT pin left asserted by failed status reads, or by an edge
+ * that was never seen.
+ */
+#define DATA_READY_WATCHDOG_CYCLES 4
 /**
- * TMP117_TEMP_REG : Register address to hold the current temperature value in signed 16-bit format.
+ * TMP117 config register 0x01 (register map in TMP117Registers.h) is built from the
+ * conversion settings of the sensor, see configurationWord(). Default:
+ * MOD[11:10] = 00 : Continuous conversion (CC) mode
+ * CONV[9:7] = 100, AVG[6:5] = 00 : 1 second conversion cycle
+ * DR/Alert[2] = 1 : ALERT pin reflects the Data_Ready flag (0 with T/nA[4] for alert/therm mode)
+ * Examples:
+ * 0x0204 : CC mode and 1 second conversion cycle
+ * 0x0384 : CC mode and 16 seconds conversion cycle
+ * 0x0424 : Shutdown mode, 8 averages, woken up by one-shot conversions
+ * 0x0200 : CC mode, 1 second conversion cycle, ALERT pin in alert mode (THIGH/TLOW)
+ * 0x0210 : CC mode, 1 second conversion cycle, ALERT pin in therm mode
  * useful commands:
  * "i2cget -y 1 0x48 0x00 w" : to read word (w) from register 0x00 of device at 0x48 on bus 1.
- * "i2cset -y 1 0x48 0x01 0x03E4 w" : to write 0x03E4 to TMP117 config register 0x01 to update settings.
+ * Note: i2cget/i2cset transfer words LSB first while the TMP117 expects MSB first,
+ * so the byte order shown by these tools is swapped.
  * Refer TMP117 Datasheet
  */
-#define TMP117_TEMP_REG 0x00
 
 // Constructor
-TMP117TemperatureSensor::TMP117TemperatureSensor(int sensor_id, Buzzer* buzzer){
+TMP117TemperatureSensor::TMP117TemperatureSensor(int sensor_id, AlarmManager* alarms, I2CBus& bus, uint8_t addr)
+	: registers(bus, addr) {
 	this->sensor_id = sensor_id;
-	this->buzzer = buzzer;
+	this->alarms = alarms;
+	if (!alarms) return; // no alarms, e.g. in the pipeline benchmark
+	AlarmManager::SourceConfig source;
+	source.name = "TMP117 " + std::to_string(sensor_id);
+	source.low = LOW_THRESHOLD;
+	source.high = HIGH_THRESHOLD;
+	source.hysteresis = ALARM_HYSTERESIS;
+	source.minInterval = ALARM_REARM;
+	// three short beeps every few seconds over the motion alarm, until cleared or acknowledged
+	source.sound.beeps = 3;
+	source.sound.onTime = std::chrono::milliseconds(150);
+	source.sound.offTime = std::chrono::milliseconds(150);
+	source.sound.repeat = 0;
+	source.sound.pause = std::chrono::seconds(5);
+	source.sound.priority = BUZZER_PRIORITY;
+	alarmSource = alarms->addSource(source);
+	// early warning on a fast rise, same sound; off until a rate limit is set
+	source.name += " rate";
+	source.low = -INFINITY;
+	source.high = INFINITY;
+	source.hysteresis = 0;
+	rateAlarmSource = alarms->addSource(source);
+}
+
+TMP117TemperatureSensor::~TMP117TemperatureSensor() {
+	stop();
+}
+
+bool TMP117TemperatureSensor::setThresholds(double low, double high) {
+	std::lock_guard<std::mutex> lock(config_mtx);
+	lowThreshold = low;
+	highThreshold = high;
+	if (alarms) alarms->setLimits(alarmSource, low, high);
+	if (!initialized || alertPin == TMP117Registers::PIN_DATA_READY) return true;
+	return applyLimits();
+}
+
+void TMP117TemperatureSensor::getThresholds(double& low, double& high) {
+	std::lock_guard<std::mutex> lock(config_mtx);
+	low = lowThreshold;
+	high = highThreshold;
+}
+
+void TMP117TemperatureSensor::setRateLimit(double perMinute) {
+	{
+		std::lock_guard<std::mutex> lock(rate_mtx);
+		rateLimit = perMinute > 0 ? perMinute : 0;
+	}
+	if (!alarms) return;
+	AlarmManager::SourceConfig source = alarms->getConfig(rateAlarmSource);
+	source.high = perMinute > 0 ? perMinute : INFINITY;
+	source.hysteresis = perMinute > 0 ? perMinute * RATE_HYSTERESIS : 0;
+	alarms->setConfig(rateAlarmSource, source);
+	// no more rate reports when switched off, clears a raised rate alarm
+	if (perMinute <= 0) alarms->reportValue(rateAlarmSource, 0, TimestampService::get().now());
+}
+
+double TMP117TemperatureSensor::getRateLimit() {
+	std::lock_guard<std::mutex> lock(rate_mtx);
+	return rateLimit;
+}
+
+void TMP117TemperatureSensor::setRateWindow(std::chrono::milliseconds window) {
+	std::lock_guard<std::mutex> lock(rate_mtx);
+	rate.setWindow(window);
+}
+
+double TMP117TemperatureSensor::getRate() {
+	std::lock_guard<std::mutex> lock(rate_mtx);
+	return rate.get();
+}
+
+void TMP117TemperatureSensor::setAlarmPolicy(double hysteresis, std::chrono::milliseconds raiseDelay, bool latching,
+					     std::chrono::milliseconds rearm) {
+	if (!alarms) return;
+	AlarmManager::SourceConfig source = alarms->getConfig(alarmSource);
+	source.hysteresis = hysteresis;
+	source.raiseDelay = raiseDelay;
+	source.latching = latching;
+	source.minInterval = rearm;
+	alarms->setConfig(alarmSource, source);
+	// the rate of change alarm is rate limited alike
+	source = alarms->getConfig(rateAlarmSource);
+	source.minInterval = rearm;
+	alarms->setConfig(rateAlarmSource, source);
 }
 
 void TMP117TemperatureSensor::readAndPrintStartupTemperature() {
@@ -55,250 +147,354 @@ void TMP117TemperatureSensor::readAndPrintStartupTemperature() {
 	}
 }
 
-//GPIO Event Handler function
+/**
+ * GPIO Event Handler function, runs on the GPIO event thread.
+ * Only records the edge with its kernel timestamp, the read, alarm, GUI and publish work is
+ * done by the processing thread so that the next edge can be taken right away.
+ */
 void TMP117TemperatureSensor:: hasEvent(gpiod_line_event& e) {
+	hasEvents(&e, 1);
+}
+
+// a burst of edges is queued with a single wakeup of the processing thread
+void TMP117TemperatureSensor::hasEvents(gpiod_line_event* events, int n) {
+	for (int i = 0; i < n; i++) {
+		Edge edge = { events[i].event_type, TimestampService::get().fromEvent(events[i]) };
+		if (!edges.push(edge)) {
+			// the status read of the queued edges picks up the latest conversion anyway
+			nOverflows++;
+		}
+	}
+	// wake the processing thread only if it sleeps (pairs with the fence in processingWorker())
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (processingWaiting.load(std::memory_order_relaxed)) {
+		std::lock_guard<std::mutex> lock(processing_mtx);
+		processing_cv.notify_one();
+	}
+}
+
+void TMP117TemperatureSensor::processingWorker() {
+	{
+		std::unique_lock<std::mutex> lock(processing_mtx);
+		ThreadConfig config = threadConfig;
+		lock.unlock();
+		config.apply(("tmp117-" + std::to_string(sensor_id)).c_str());
+	}
+	Edge edge;
+	while (true) {
+		if (edges.pop(edge)) {
+			process(edge);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(processing_mtx);
+		processingWaiting.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		// also woken up when the watchdog is re-armed, e.g. by a one-shot trigger
+		int64_t due = watchdogDueNs.load();
+		auto woken = [this, due]() { return !edges.empty() || !processingRunning || watchdogDueNs.load() != due; };
+		bool expired = false;
+		if (due == 0) {
+			processing_cv.wait(lock, woken);
+		} else {
+			expired = !processing_cv.wait_until(lock, std::chrono::steady_clock::time_point(std::chrono::nanoseconds(due)), woken);
+		}
+		processingWaiting.store(false, std::memory_order_relaxed);
+		if (!processingRunning && edges.empty()) break; // stopped and drained
+		if (expired) {
+			lock.unlock();
+			watchdog();
+		}
+	}
+}
 
-	/*Update the Raspberry Pi system date...*/
-	system("sudo ntpdate time.google.com > /dev/null 2>&1");
-	auto now = std::chrono::system_clock::now();
-	std::time_t currentTime = std::chrono::system_clock::to_time_t(now);
-	std::string timeStr = std::ctime(&currentTime);
-	timeStr.pop_back(); // removes the '\n' from the end
-	SafePrint::printf("\n[ %s ] :: [TMP117TemperatureSensor::hasEvent() {%d}] : interrupt received!\n\r", timeStr.c_str(), sensor_id);
+void TMP117TemperatureSensor::startProcessing() {
+	std::lock_guard<std::mutex> lock(processing_mtx);
+	if (processingRunning) return;
+	processingRunning = true;
+	processingThread = std::thread(&TMP117TemperatureSensor::processingWorker, this);
+}
+
+void TMP117TemperatureSensor::setThreadConfig(const ThreadConfig& config) {
+	std::lock_guard<std::mutex> lock(processing_mtx);
+	threadConfig = config;
+}
+
+void TMP117TemperatureSensor::stop() {
+	{
+		std::lock_guard<std::mutex> lock(processing_mtx);
+		if (!processingRunning) return;
+		processingRunning = false;
+	}
+	processing_cv.notify_one();
+	processingThread.join();
+}
+
+void TMP117TemperatureSensor::process(const Edge& edge) {
+	/**
+	 * Timestamp the sample with the kernel time of the interrupt, converted to wall time.
+	 * The system clock itself is kept in sync by the system time daemon, not on this path.
+	 */
+	char timeStr[TimestampService::FORMAT_SIZE];
+	TimestampService::format(edge.timestampNs, timeStr, sizeof(timeStr));
+	SAFE_PRINTF("\n[ %s ] :: [TMP117TemperatureSensor::hasEvent() {%d}] : interrupt received!\n\r", timeStr, sensor_id);
+
+	TMP117Registers::AlertPin pin = getAlertPin();
 	
 	/*Read the Temperature value when DATA READY INTERRUPT Pin is Low*/
-	switch (e.event_type) {
+	switch (edge.eventType) {
 		case GPIOD_LINE_EVENT_RISING_EDGE:
 		{	/**
-			* TMP117 sends the rising event after the 0x00 or 0x01 register has been read. 
+			* TMP117 sends the rising event after the 0x00 or 0x01 register has been read
+			* (Data_Ready) or after the configuration register has been read (alert mode).
+			* In therm mode it is sent once the temperature has dropped below TLOW.
 			*/
 
-			SafePrint::printf("[TMP117TemperatureSensor::hasEvent() {%d}] : Rising!\n\r", sensor_id);
+			SAFE_PRINTF("[TMP117TemperatureSensor::hasEvent() {%d}] : Rising!\n\r", sensor_id);
+			if (pin == TMP117Registers::PIN_THERM) {
+				handleLimitEvent(pin, false, edge.timestampNs);
+			}
 			break;
 		}
 		case GPIOD_LINE_EVENT_FALLING_EDGE:
 		{	/**
 				* TMP117 sends the falling event after temperature conversion result is ready in the
-				* 0x00 register.
+				* 0x00 register, or after a result crossed the THIGH/TLOW limits in alert/therm mode.
 				*/
-			SafePrint::printf("[TMP117TemperatureSensor::hasEvent() {%d}] : Falling\n\r", sensor_id);
-			double temperature = readTemperature();
-
-			if (std::isnan(temperature)) { //Error handling: Invalid value
-				SafePrint::printf("[TMP117TemperatureSensor::hasEvent() {%d}] : Failed to read temperature.\n\r", sensor_id);
+			SAFE_PRINTF("[TMP117TemperatureSensor::hasEvent() {%d}] : Falling\n\r", sensor_id);
+			if (pin == TMP117Registers::PIN_DATA_READY) {
+				handleDataReady(edge.timestampNs);
 			} else {
-				SafePrint::printf("[TMP117TemperatureSensor::hasEvent() {%d}] : 🌡️ Temperature: %.2f °C\n\r", sensor_id, temperature);
-				
-				/**
-				 * [ALERT!] Send the Buzzer beep alert when Temperature has crossed the threshold range
-				 */
-				if (temperature > HIGH_THRESHOLD || temperature < LOW_THRESHOLD) {
-					SafePrint::printf("⚠️ [ALERT!] [TMP117TemperatureSensor::hasEvent() {%d}] :Trigger the buzzer beep to alert! \n\r", sensor_id);
-					buzzer->on();
-					sleep(1);
-					buzzer->off();
-				}
-				
-				onTemperatureRead(temperature); //QT
-				
-				//Publish
-				message.timestamp(timeStr.c_str());
-				message.sensor_id(sensor_id);
-    			message.temperature(temperature);
-				if (msgPublisher->publish(message))
-				{
-					SafePrint::printf("Publisher SENT message: Sensor Id {%d} has recorded Temperature {%f} on {%s}\n\r",sensor_id, temperature,timeStr.c_str());
-					
-				} else {
-					SafePrint::printf("No messages sent as there is no listener.\n\r");
-				}
+				handleLimitEvent(pin, true, edge.timestampNs);
 			}
-			
 			break;
 		}
 		default:
 		SafePrint::printf("[TMP117TemperatureSensor::hasEvent() {%d}] : Unkown event\n\r", sensor_id);
 	}
 }
+
 /**
- * Function to read temperature from TMP117 over I2C
+ * The configuration register is read together with the result: the Data_Ready flag tells
+ * whether the result is a new conversion (the flag is cleared by the read), so repeated
+ * edges such as the one passed on at startup never publish the same conversion twice.
  */
-double TMP117TemperatureSensor::readTemperature() {
-	SafePrint::printf("[TMP117TemperatureSensor::readTemperature() {%d}] : waiting for I2C lock.\n\r", sensor_id);
-	std::lock_guard<std::mutex> lock(i2c_mutex); //acquire the lock to use I2C bus
-/*
-* Step#1: Opening the I2C Bus Device File:
-* --------------------------------
-* The I2C bus on Raspberry Pi is exposed as a device file (typically /dev/i2c-1).
-* To communicate with I2C devices like TMP117, we need to open this file.
-* 
-* Function:
-*     int fd = open(const char *pathname, int flags);
-* 
-* Parameters:
-*     - pathname: The path to the I2C bus device file (e.g., "/dev/i2c-1").
-*     - flags: Access mode for the file. We use O_RDWR (read/write access) because
-*              we need to both write to and read from the I2C device. 
-* 				Other possible flag values are:
-* 				O_RDONLY	Open for reading only
-*				O_WRONLY	Open for writing only
-*				O_NONBLOCK	Non-blocking mode
-*				O_SYNC		Writes complete synchronously
-* 
-* 
-* Return Value:
-*     - On success: Returns a non-negative integer file descriptor (fd).
-*     - On failure: Returns -1, and sets errno to indicate the specific error.
-* 
-* Usage in I2C:
-*     - The returned file descriptor is used with ioctl() to specify the target I2C device address.
-*     - Then, read() and write() system calls are used to communicate with the device.
-*     - Always close(fd) when done to free the resource.
-*/
-int fd = open(I2C_BUS, O_RDWR);
-if (fd < 0) {
-	SafePrint::printf("[TMP117TemperatureSensor::readTemperature() {%d}] : Error : Failed to open I2C bus!\n\r", sensor_id);
-	return NAN;
+void TMP117TemperatureSensor::handleDataReady(int64_t timestampNs) {
+	uint16_t config;
+	double temperature;
+	int64_t readNs = TimestampService::get().now();
+	if (!readStatus(config, temperature)) { //Error handling: bus error
+		SafePrint::printf("[TMP117TemperatureSensor::hasEvent() {%d}] : Failed to read temperature.\n\r", sensor_id);
+		return;
+	}
+	if (!(config & TMP117Registers::CFG_DATA_READY)) {
+		nDuplicates++;
+		SAFE_PRINTF("[TMP117TemperatureSensor::hasEvent() {%d}] : No new conversion since the last read, %.2f °C dropped\n\r", sensor_id, temperature);
+		return;
+	}
+	nFresh++;
+	armWatchdog(false);
+	checkMissedConversions(timestampNs, readNs);
+	SAFE_PRINTF("[TMP117TemperatureSensor::hasEvent() {%d}] : 🌡️ Temperature: %.2f °C\n\r", sensor_id, temperature);
+
+	/**
+	 * [ALERT!] The alarm manager raises the alarm when Temperature has crossed the threshold range
+	 */
+	report(temperature, timestampNs, checkAlarm(temperature, timestampNs));
 }
 
 /**
-* Step#2: Setting the I2C Slave Address:
-* ---------------------------------
-* Function:
-*     int ioctl(int fd, unsigned long request, int arg);
-* 
-* Purpose:
-*     Configures which I2C slave device we are targeting (For example: TMP117 address 0x48).
-* 
-* Parameters:
-*     - fd: File descriptor returned by open().
-*     - request: I2C_SLAVE → Tells the kernel to set the target slave address.
-*     - arg: The 7-bit slave address (0x48 for TMP117 default).
-* 
-* Returns:
-*     - 0 on success.
-*     - -1 on failure; errno set accordingly.
-* 
-* Example:
-*     if (ioctl(fd, I2C_SLAVE, 0x48) < 0) {
-*         // Handle error
-*     }
-*/
-if (sensor_id == 1){
-	if (ioctl(fd, I2C_SLAVE, TMP117_ADDR1) < 0) {
-		SafePrint::printf("[TMP117TemperatureSensor::readTemperature() {%d}] : Error : Failed to set I2C address! %s\n\r", sensor_id, strerror(errno));
-		close(fd);
-		return NAN;
+ * The sensor has compared the result against THIGH/TLOW itself, so the host only gets here
+ * when a limit has been crossed.
+ * Alert mode: the HIGH/LOW alert flags tell which limit, reading them releases the ALERT pin.
+ * Therm mode: the pin is asserted above THIGH and released below TLOW, the flags follow the pin.
+ */
+void TMP117TemperatureSensor::handleLimitEvent(TMP117Registers::AlertPin pin, bool asserted, int64_t timestampNs) {
+	uint16_t config;
+	double temperature;
+	if (!readStatus(config, temperature)) {
+		SafePrint::printf("[TMP117TemperatureSensor::hasEvent() {%d}] : Failed to read temperature.\n\r", sensor_id);
+		return;
+	}
+
+	double low, high;
+	{
+		std::lock_guard<std::mutex> lock(config_mtx);
+		low = lowThreshold;
+		high = highThreshold;
+	}
+	bool alarm;
+	if (pin == TMP117Registers::PIN_THERM) {
+		alarm = asserted;
+	} else {
+		alarm = config & (TMP117Registers::CFG_HIGH_ALERT | TMP117Registers::CFG_LOW_ALERT);
 	}
+
+	if (alarm) {
+		SAFE_PRINTF("[TMP117TemperatureSensor::hasEvent() {%d}] : 🌡️ Temperature: %.2f °C outside [%.2f, %.2f] °C\n\r", sensor_id, temperature, low, high);
+	} else {
+		SAFE_PRINTF("[TMP117TemperatureSensor::hasEvent() {%d}] : 🌡️ Temperature: %.2f °C back within limits\n\r", sensor_id, temperature);
+	}
+
+	// the alarm itself follows the value with the hysteresis of the alarm manager
+	report(temperature, timestampNs, checkAlarm(temperature, timestampNs));
 }
-else if (sensor_id == 2){
-	if (ioctl(fd, I2C_SLAVE, TMP117_ADDR2) < 0) {
-		SafePrint::printf("[TMP117TemperatureSensor::readTemperature() {%d}] : Error : Failed to set I2C address! %s\n\r", sensor_id, strerror(errno));
-		close(fd);
-		return NAN;
+
+bool TMP117TemperatureSensor::readStatus(uint16_t& config, double& temperature) {
+	for (int attempt = 0; attempt < STATUS_READ_ATTEMPTS; attempt++) {
+		if (registers.readStatusAndTemperature(config, temperature)) return true;
+		nReadErrors++;
 	}
+	return false;
 }
+
 /**
- * Latest: Sytem is working fine without any delay being added
- * Old: recommended to add a short delay after interrupt to ensure the TMP117 data is stable
+ * Sets the watchdog deadline from now: DATA_READY_WATCHDOG_CYCLES conversion cycles in
+ * continuous mode, as many conversion times after a one-shot trigger. Off otherwise, and in
+ * alert/therm mode, where the sensor is polled by the SampleScheduler.
  */
-//usleep(5000); //2000 was giving Error: Failed to write to TMP117! Remote I/O error
+void TMP117TemperatureSensor::armWatchdog(bool oneShotTriggered) {
+	int64_t periodNs = 0;
+	{
+		std::lock_guard<std::mutex> lock(config_mtx);
+		if (initialized && alertPin == TMP117Registers::PIN_DATA_READY) {
+			if (conversion.mode == TMP117Registers::MODE_CONTINUOUS) {
+				periodNs = TMP117Registers::cycleTimeUs(conversion.cycle, conversion.averaging) * 1000LL;
+			} else if (conversion.mode == TMP117Registers::MODE_ONE_SHOT && oneShotTriggered) {
+				periodNs = TMP117Registers::conversionTimeUs(conversion.averaging) * 1000LL;
+			}
+		}
+	}
+	int64_t due = 0;
+	if (periodNs > 0) {
+		int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+		due = now + DATA_READY_WATCHDOG_CYCLES * periodNs;
+	}
+	if (watchdogDueNs.exchange(due) != due && processingWaiting.load()) {
+		std::lock_guard<std::mutex> lock(processing_mtx);
+		processing_cv.notify_one();
+	}
+}
 
 /**
-*
-* step#3. Writing register address to the I2C Device:
-* -----------------------------
-* Function:
-*     ssize_t write(int fd, const void *buf, size_t count);
-* 
-* Purpose:
-*     Sends data to the I2C slave device.
-*     Typically used to send the register address you want to read from or write to.
-* 
-* Parameters:
-*     - fd: File descriptor.
-*     - buf: Pointer to data buffer (e.g., register address).
-*     - count: Number of bytes to write (usually 1 byte for register).
-* 
-* Returns:
-*     - Number of bytes written on success.
-*     - -1 on failure; errno set accordingly.
-* 
-* Example:
-*     unsigned char reg = 0x00; // Temperature register
-*     if (write(fd, &reg, 1) != 1) {
-*         // Handle error
-*     }
-* 
-*/
-
-unsigned char reg = TMP117_TEMP_REG;
-if (write(fd, &reg, 1) != 1) {
-	SafePrint::printf("[TMP117TemperatureSensor::readTemperature() {%d}] : Error : Failed to write to TMP117! %s\n\r", sensor_id, strerror(errno));
-	close(fd);
-	return NAN;
-}
-
-usleep(1000); //recommended to add a delay between write() and read()
-/**
-*
-* step#4. Reading value from the I2C Device:
-* -------------------------------
-* Function:
-*     ssize_t read(int fd, void *buf, size_t count);
-* 
-* Purpose:
-*     Reads data from the I2C slave device.
-* 
-* Parameters:
-*     - fd: File descriptor.
-*     - buf: Buffer to store received data.
-*     - count: Number of bytes to read (2 bytes for TMP117 temperature).
-* 
-* Returns:
-*     - Number of bytes read on success.
-*     - -1 on failure; errno set accordingly.
-* 
-* Example:
-*     unsigned char buffer[2];
-*     if (read(fd, buffer, 2) != 2) {
-*         // Handle error
-*     }
-* 
-*/
-unsigned char buffer[2];
-if (read(fd, buffer, 2) != 2) {
-	SafePrint::printf("[TMP117TemperatureSensor::readTemperature() {%d}] : Error : Failed to read temperature data!\n\r", sensor_id);
-	close(fd);
-	return NAN;
-}
-//DEBUG START
-//SafePrint::printf("[TMP117TemperatureSensor::readTemperature() {%d}] : DATA READY Alert should be cleared after this read.\n\r", sensor_id);
-//DEBUG END
+ * No new conversion within the watchdog period: the edge of the last conversion was lost or
+ * its status read failed, so the ALERT pin is still asserted and will not generate another
+ * edge. Reading the status takes the latest conversion and releases the pin.
+ */
+void TMP117TemperatureSensor::watchdog() {
+	nWatchdog++;
+	SafePrint::printf("[TMP117TemperatureSensor::watchdog() {%d}] : [WARNING] : no new conversion for %d cycles, reading the status\n\r",
+			  sensor_id, DATA_READY_WATCHDOG_CYCLES);
+	uint64_t duplicates = nDuplicates;
+	// re-armed first: retried after another period if the read fails again
+	armWatchdog(true);
+	handleDataReady(TimestampService::get().now());
+	// no one-shot conversion pending after all, nothing to wait for until the next trigger
+	if (nDuplicates != duplicates) armWatchdog(false);
+}
 
 /**
-* 
-* step#5. Closing the I2C Bus:
-* -----------------------
-* Function:
-*     int close(int fd);
-* 
-* Purpose:
-*     Closes the I2C bus file descriptor to release system resources.
-* 
-* Example:
-*     close(fd);
-* 
-*/
-close(fd);
+ * In continuous conversion mode a new result is expected every conversion cycle. The edge
+ * marks a conversion, but when the read is late (e.g. events queued up) the result read is the
+ * latest conversion on the grid of that edge before the read started. A gap of several cycles
+ * between two results read means conversions were overwritten unread; no edge is generated
+ * for them as the ALERT pin is still asserted.
+ */
+void TMP117TemperatureSensor::checkMissedConversions(int64_t edgeNs, int64_t readNs) {
+	int64_t cycleNs;
+	{
+		std::lock_guard<std::mutex> lock(config_mtx);
+		if (conversion.mode != TMP117Registers::MODE_CONTINUOUS) {
+			lastConversionNs = 0;
+			return;
+		}
+		cycleNs = TMP117Registers::cycleTimeUs(conversion.cycle, conversion.averaging) * 1000LL;
+	}
+	int64_t conversionNs = edgeNs;
+	if (readNs > edgeNs) conversionNs += (readNs - edgeNs) / cycleNs * cycleNs;
+	int64_t last = lastConversionNs.exchange(conversionNs);
+	if (last == 0) return;
+	int64_t cycles = llround((double)(conversionNs - last) / cycleNs);
+	if (cycles > 1) {
+		nMissed += cycles - 1;
+		SAFE_PRINTF("[TMP117TemperatureSensor::hasEvent() {%d}] : [WARNING] : %lld conversion(s) missed\n\r", sensor_id, (long long)(cycles - 1));
+	}
+}
+
+TMP117TemperatureSensor::ReadStats TMP117TemperatureSensor::getReadStats() const {
+	ReadStats s;
+	s.fresh = nFresh;
+	s.duplicates = nDuplicates;
+	s.missed = nMissed;
+	s.errors = nReadErrors;
+	s.overflows = nOverflows;
+	s.watchdog = nWatchdog;
+	return s;
+}
+
+void TMP117TemperatureSensor::printReadStats() const {
+	ReadStats s = getReadStats();
+	SafePrint::printf("[TMP117TemperatureSensor {%d}] : conversions %llu, duplicates dropped %llu, missed %llu, read errors %llu, edge queue overflows %llu, watchdog reads %llu\n\r",
+			  sensor_id, (unsigned long long)s.fresh, (unsigned long long)s.duplicates,
+			  (unsigned long long)s.missed, (unsigned long long)s.errors, (unsigned long long)s.overflows,
+			  (unsigned long long)s.watchdog);
+}
+
+AlarmManager::Condition TMP117TemperatureSensor::checkAlarm(double temperature, int64_t timestampNs) {
+	double perMinute;
+	bool rateAlarm;
+	{
+		std::lock_guard<std::mutex> lock(rate_mtx);
+		perMinute = rate.add(timestampNs, temperature);
+		rateAlarm = rateLimit > 0;
+	}
+	if (!alarms) return AlarmManager::NORMAL;
+	if (rateAlarm && !std::isnan(perMinute)) alarms->reportValue(rateAlarmSource, perMinute, timestampNs);
+	return alarms->reportValue(alarmSource, temperature, timestampNs);
+}
+
+void TMP117TemperatureSensor::report(double temperature, int64_t timestampNs, AlarmManager::Condition alarm) {
+	char timeStr[TimestampService::FORMAT_SIZE];
+	TimestampService::format(timestampNs, timeStr, sizeof(timeStr));
 
+	std::lock_guard<std::mutex> lock(report_mtx);
+	onTemperatureRead(temperature, timestampNs); //QT
+	
+	//Publish
+	message.timestamp(timeStr);
+	message.timestamp_ns(timestampNs);
+	message.sensor_id(sensor_id);
+	message.temperature(temperature);
+	message.alarm(alarm);
+	if (msgPublisher->publish(message))
+	{
+		SAFE_PRINTF("Publisher SENT message: Sensor Id {%d} has recorded Temperature {%f} on {%s}\n\r",sensor_id, temperature,timeStr);
+		
+	} else {
+		SAFE_PRINTF("No messages sent as there is no listener.\n\r");
+	}
+}
 /**
- * Convert raw data to temperature in degree celcius 
- * TMP117 generates a signed 16-bit value as a raw output
- * Refer TMP117 Data sheet for more information
+ * Function to read temperature from TMP117 over I2C
+ *
+ * The register pointer write and the 2 byte read are sent as one combined I2C_RDWR
+ * transaction on the long-lived bus session (see I2CBus.h), so no open()/ioctl(I2C_SLAVE)/close()
+ * per sample and no delay between write() and read() are needed any more.
+ * Refer docs/I2C_Communication_Explanation.md for the underlying system calls.
  */
-int16_t rawTemp = (buffer[0] << 8) | buffer[1];
-return rawTemp * 0.0078125;  // Conversion formula from TMP117 datasheet
+double TMP117TemperatureSensor::readTemperature() {
+	/**
+	 * TMP117 generates a signed 16-bit value as a raw output, converted to degree celcius
+	 * with 0.0078125 °C per LSB (see TMP117Registers::toCelsius())
+	 * Refer TMP117 Data sheet for more information
+	 */
+	double temperature;
+	if (!registers.readTemperature(temperature)) {
+		nReadErrors++;
+		SafePrint::printf("[TMP117TemperatureSensor::readTemperature() {%d}] : Error : Failed to read temperature data!\n\r", sensor_id);
+		return NAN;
+	}
+	return temperature;
 }
 	
 /**
@@ -312,66 +508,162 @@ return rawTemp * 0.0078125;  // Conversion formula from TMP117 datasheet
  * DR/nAlert_EN bit in the configuration register to monitor the state of the Data_Ready flag on the ALERT pin.
  */
 	
-void TMP117TemperatureSensor::initialize() {
-	std::lock_guard<std::mutex> lock(i2c_mutex);
+bool TMP117TemperatureSensor::initialize() {
+	startProcessing();
 
-	int addr = (sensor_id == 1) ? 0x48 : 0x49;
-	char devicePath[] = "/dev/i2c-1";
+	// Read device ID (0x0F) to verify sensor presence
+	uint16_t device_id;
+	if (!registers.readDeviceId(device_id)) {
+		SafePrint::printf("[TMP117TemperatureSensor::initialize() {%d}] : [ERROR] : Device ID read failed \n\r", sensor_id);
+		return false;
+	}
+	SafePrint::printf("[TMP117TemperatureSensor::initialize() {%d}] : Detected TMP117 (ID: 0x%04X)\n\r", sensor_id, device_id);
 
-	int fd = open(devicePath, O_RDWR);
-	if (fd < 0) {
-		SafePrint::printf("[TMP117TemperatureSensor::initialize()] : [ERROR] : I2C open failed \n\r");
-		return;
+	/**
+	 * Configure the TMP117 config register 0x01 with the conversion settings and Data_Ready on
+	 * the ALERT pin. The word is written MSB first on the already-open bus session and read back
+	 * to verify it has been taken over.
+	 */
+	bool ok;
+	{
+		std::lock_guard<std::mutex> lock(config_mtx);
+		ok = initialized = applyConfiguration();
 	}
+	armWatchdog(false);
+	return ok;
+}
 
-	if (ioctl(fd, I2C_SLAVE, addr) < 0) {
-		SafePrint::printf("[TMP117TemperatureSensor::initialize()] : [ERROR] : I2C address set failed \n\r");
-		close(fd);
-		return;
+/**
+ * In one-shot mode the sensor is parked in shutdown mode and only converts when
+ * triggerOneShot() is called, so the verified configuration uses MOD = shutdown.
+ */
+uint16_t TMP117TemperatureSensor::configurationWord(TMP117Registers::Mode mode) const {
+	TMP117Registers::ConversionSettings settings = conversion;
+	settings.mode = mode;
+	return TMP117Registers::encode(settings, alertPin);
+}
+
+/**
+ * THIGH/TLOW are written to the volatile limit registers only, the power-up values
+ * come from EEPROM (see TMP117Registers::programEEPROM()).
+ */
+bool TMP117TemperatureSensor::applyLimits() {
+	if (!registers.writeHighLimit(highThreshold) || !registers.writeLowLimit(lowThreshold)) {
+		SafePrint::printf("[TMP117TemperatureSensor::applyLimits() {%d}] : [ERROR] : Limits could not be written\n\r", sensor_id);
+		return false;
 	}
+	SafePrint::printf("[TMP117TemperatureSensor::applyLimits() {%d}] : THIGH %.2f °C, TLOW %.2f °C\n\r", sensor_id, highThreshold, lowThreshold);
+	return true;
+}
 
-	usleep(200000); // Wait for TMP117 boot
+bool TMP117TemperatureSensor::applyConfiguration() {
+	// limits first, so that the pin does not react to stale limits once the mode is switched
+	if (alertPin != TMP117Registers::PIN_DATA_READY && !applyLimits()) return false;
 
-	// Read device ID (0x0F) to verify sensor presence
-	unsigned char reg = 0x0F; //device ID register
-	unsigned char id_buf[2];
-	if (write(fd, &reg, 1) != 1 || read(fd, id_buf, 2) != 2) {
-		SafePrint::printf("[TMP117TemperatureSensor::initialize()] : [ERROR] : Device ID read failed \n\r");
-		close(fd);
-		return;
+	TMP117Registers::Mode mode = conversion.mode == TMP117Registers::MODE_ONE_SHOT ? TMP117Registers::MODE_SHUTDOWN : conversion.mode;
+	uint16_t config = configurationWord(mode);
+	if (!registers.writeConfiguration(config)) {
+		SafePrint::printf("[TMP117TemperatureSensor::applyConfiguration() {%d}] : [ERROR] : Configuration 0x%04X could not be written\n\r", sensor_id, config);
+		return false;
 	}
+	SafePrint::printf("[TMP117TemperatureSensor::applyConfiguration() {%d}] : Configuration 0x%04X written and verified (%s, ALERT pin %s, cycle %.1f ms, %d averages)\n\r",
+			  sensor_id, config, modeName(conversion.mode), alertPinName(alertPin),
+			  TMP117Registers::cycleTimeUs(conversion.cycle, conversion.averaging) / 1000.0,
+			  TMP117Registers::averagingCount(conversion.averaging));
+	return true;
+}
 
-	uint16_t device_id = (id_buf[0] << 8) | id_buf[1];
-	SafePrint::printf("[TMP117TemperatureSensor::initialize() {%d}] : Detected TMP117 (ID: 0x%04X)\n\r", sensor_id, device_id);
+const char* TMP117TemperatureSensor::modeName(TMP117Registers::Mode mode) {
+	switch (mode) {
+		case TMP117Registers::MODE_CONTINUOUS: return "continuous";
+		case TMP117Registers::MODE_SHUTDOWN: return "shutdown";
+		case TMP117Registers::MODE_ONE_SHOT: return "one-shot";
+	}
+	return "unknown";
+}
 
-	/**
-	 * Construct i2cset command string to configure the TMP117 config register 0x01
-	 * For: 
-	 * Continuous conversion (CC) mode, and
-	 * 16 seconds conversion cycle time 
-	 * IMPORTANT:
-	 * Config value should be in little-endian representation. Take the lower byte first, then the higher byte second.
-	 * Examples:
-	 * 0x8403 : CC mode and 16 seconds conversion cycle
-	 * 0x0400 : CC mode and 1 second conversion cycle
-	 */ 
-	char cmd[128];
-	//snprintf(cmd, sizeof(cmd), "i2cset -y 1 0x%02X 0x01 0x8403 w", addr);
-	snprintf(cmd, sizeof(cmd), "i2cset -y 1 0x%02X 0x01 0x0400 w", addr);
-	SafePrint::printf("[TMP117TemperatureSensor::initialize() {%d}] : Running : %s\n\r", sensor_id, cmd);
-
-	int ret = system(cmd);
-	if (ret != 0) {
-		SafePrint::printf("[TMP117TemperatureSensor::initialize() {%d}] : [ERROR] : i2cset command failed with return code %d\n\r", sensor_id, ret);
-		close(fd);
-		return;
+const char* TMP117TemperatureSensor::alertPinName(TMP117Registers::AlertPin pin) {
+	switch (pin) {
+		case TMP117Registers::PIN_DATA_READY: return "data ready";
+		case TMP117Registers::PIN_ALERT: return "alert";
+		case TMP117Registers::PIN_THERM: return "therm";
 	}
+	return "unknown";
+}
 
-	close(fd);
+bool TMP117TemperatureSensor::setConversion(const TMP117Registers::ConversionSettings& settings) {
+	bool applied;
+	{
+		std::lock_guard<std::mutex> lock(config_mtx);
+		conversion = settings;
+		lastConversionNs = 0; // the conversion cycle restarts
+		if (!initialized) return true; // taken over by initialize()
+		applied = applyConfiguration();
+	}
+	armWatchdog(false);
+	return applied;
 }
 
-void TMP117TemperatureSensor::setSensorMsgPublisher(SensorMsgPublisher* pub){
-	this->msgPublisher = pub;
+TMP117Registers::ConversionSettings TMP117TemperatureSensor::getConversion() {
+	std::lock_guard<std::mutex> lock(config_mtx);
+	return conversion;
+}
+
+bool TMP117TemperatureSensor::setAlertPin(TMP117Registers::AlertPin pin) {
+	bool applied;
+	{
+		std::lock_guard<std::mutex> lock(config_mtx);
+		alertPin = pin;
+		if (!initialized) return true; // taken over by initialize()
+		applied = applyConfiguration();
+	}
+	armWatchdog(false);
+	return applied;
+}
+
+TMP117Registers::AlertPin TMP117TemperatureSensor::getAlertPin() {
+	std::lock_guard<std::mutex> lock(config_mtx);
+	return alertPin;
+}
+
+/**
+ * Starts a single conversion. The sensor signals Data_Ready on the ALERT pin after
+ * TMP117Registers::conversionTimeUs() and the result is read by hasEvent() as usual.
+ * Only useful with the data ready ALERT pin: in alert/therm mode the pin only reacts if the
+ * result crosses a limit, so the result would not be read otherwise.
+ */
+bool TMP117TemperatureSensor::triggerOneShot() {
+	{
+		std::lock_guard<std::mutex> lock(config_mtx);
+		if (!initialized || conversion.mode != TMP117Registers::MODE_ONE_SHOT) return false;
+		// no readback: the MOD bits return to shutdown on their own once the conversion is done
+		if (!registers.writeWord(TMP117Registers::CONFIGURATION, configurationWord(TMP117Registers::MODE_ONE_SHOT))) return false;
+	}
+	armWatchdog(true);
+	return true;
 }
 
+bool TMP117TemperatureSensor::sample() {
+	TMP117Registers::Mode mode;
+	{
+		std::lock_guard<std::mutex> lock(config_mtx);
+		if (!initialized) return false;
+		mode = conversion.mode;
+	}
+	if (mode == TMP117Registers::MODE_ONE_SHOT) return triggerOneShot();
 
+	/**
+	 * telemetry: the limits are checked by the sensor itself, but its ALERT edges only mark
+	 * crossings, so the alarm manager sees the way back inside the limits from these samples
+	 */
+	int64_t timestampNs = TimestampService::get().now();
+	double temperature = readTemperature();
+	if (std::isnan(temperature)) return false;
+	SAFE_PRINTF("[TMP117TemperatureSensor::sample() {%d}] : 🌡️ Temperature: %.2f °C\n\r", sensor_id, temperature);
+	report(temperature, timestampNs, checkAlarm(temperature, timestampNs));
+	return true;
+}
+
+void TMP117TemperatureSensor::setSensorMsgPublisher(SensorMsgPublisher* pub){
+	this->msgPublisher = pub;
+}
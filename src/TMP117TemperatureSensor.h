@@ -2,29 +2,207 @@
 #define TMP117_TEMPERATURE_SENSOR_H
 
 #include "gpioevent.h"
-#include "buzzer.h"
+#include "AlarmManager.h"
+#include "RateOfChange.h"
 #include "SensorMsgPublisher.h"
 #include "SensorMsg.h"
+#include "TMP117Registers.h"
+#include "SPSCQueue.h"
+#include "ThreadConfig.h"
+#include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <mutex>
+#include <thread>
 
 class TMP117TemperatureSensor : public GPIOPin::GPIOEventCallbackInterface {
 public:
-    TMP117TemperatureSensor(int sensor_id, Buzzer* buzzer);
-    void initialize();
+    /**
+     * \param sensor_id Unique id used in logs, GUI and published messages.
+     * \param alarms Alarm manager the temperature alarm of the sensor is raised on, may be nullptr.
+     * \param bus I2C bus session the sensor is attached to.
+     * \param addr I2C address selected by the ADDR pin (0x48 - 0x4B).
+     **/
+    TMP117TemperatureSensor(int sensor_id, AlarmManager* alarms, I2CBus& bus, uint8_t addr);
+    ~TMP117TemperatureSensor();
+
+    /**
+     * Starts the processing thread and configures the sensor. May be called again after a
+     * failure, e.g. a bus error.
+     * \return false if the sensor did not answer or the configuration could not be written.
+     **/
+    bool initialize();
+
+    // Stops the processing thread after the queued edges have been handled.
+    void stop();
+
+    // Real-time settings of the processing thread, must be set before initialize().
+    void setThreadConfig(const ThreadConfig& config);
+
     void readAndPrintStartupTemperature();
     double readTemperature();
     void hasEvent(gpiod_line_event& e) override;
-    std::function<void(double)> onTemperatureRead;
+    void hasEvents(gpiod_line_event* events, int n) override;
+    // called with the temperature and its wall clock timestamp in ns since the epoch
+    std::function<void(double, int64_t)> onTemperatureRead;
     void setSensorMsgPublisher(SensorMsgPublisher* pub);
 
+    /**
+     * Alert range of this sensor, defaults to [LOW_THRESHOLD, HIGH_THRESHOLD]. Also written
+     * to the THIGH/TLOW limit registers when the ALERT pin is in alert or therm mode.
+     * \return false if the limits could not be written to the sensor.
+     **/
+    bool setThresholds(double low, double high);
+    void getThresholds(double& low, double& high);
+    int getSensorId() const { return sensor_id; }
+    // source of this sensor on the alarm manager, -1 without one
+    int getAlarmSource() const { return alarmSource; }
+    // source of the rate of change alarm on the alarm manager, -1 without one
+    int getRateAlarmSource() const { return rateAlarmSource; }
+
+    /**
+     * Rate of change alarm: raised when the temperature rises faster than perMinute °C/min,
+     * as the slope over the rate window (setRateWindow()). 0 switches it off (default).
+     **/
+    void setRateLimit(double perMinute);
+    double getRateLimit();
+    // Length of the sliding window the rate is fitted over, RATE_WINDOW by default.
+    void setRateWindow(std::chrono::milliseconds window);
+    // rate of change over the window at the last sample in °C/min, NAN until the window has filled
+    double getRate();
+
+    /**
+     * Alarm policy of this sensor: hysteresis in °C back inside a limit before the alarm
+     * clears, time a limit must stay crossed before the alarm is raised, whether the alarm
+     * stays raised until acknowledged, and the least time between two raises of the alarm.
+     * Defaults to ALARM_HYSTERESIS, 0, false and ALARM_REARM.
+     **/
+    void setAlarmPolicy(double hysteresis, std::chrono::milliseconds raiseDelay, bool latching,
+			std::chrono::milliseconds rearm = ALARM_REARM);
+
+    /**
+     * Selects conversion mode (continuous, shutdown or one-shot), conversion cycle and
+     * averaging. Applied immediately if the sensor has already been initialized.
+     * \return false if the configuration could not be written to the sensor.
+     **/
+    bool setConversion(const TMP117Registers::ConversionSettings& settings);
+    TMP117Registers::ConversionSettings getConversion();
+
+    /**
+     * Selects the function of the ALERT pin (see TMP117Registers::AlertPin). In alert and
+     * therm mode the sensor compares every result against the thresholds itself and the
+     * host is only woken up when a limit is crossed; telemetry is then read with sample().
+     * Not combined with one-shot mode, whose results are only read through Data_Ready.
+     * Applied immediately if the sensor has already been initialized.
+     * \return false if the configuration could not be written to the sensor.
+     **/
+    bool setAlertPin(TMP117Registers::AlertPin pin);
+    TMP117Registers::AlertPin getAlertPin();
+
+    /**
+     * Starts one conversion when the sensor is in one-shot mode.
+     * \return false if not in one-shot mode or the bus write failed.
+     **/
+    bool triggerOneShot();
+
+    /**
+     * Periodic sample driven by SampleScheduler: triggers a conversion in one-shot mode,
+     * otherwise reads and reports the latest result (telemetry poll in alert/therm mode).
+     * \return false if the sensor could not be accessed.
+     **/
+    bool sample();
+
+    /**
+     * Data_Ready read path counters, cumulative since start.
+     **/
+    struct ReadStats {
+	uint64_t fresh = 0;       // new conversions read and reported
+	uint64_t duplicates = 0;  // reads without a new conversion, dropped
+	uint64_t missed = 0;      // conversions overwritten before they were read (continuous mode)
+	uint64_t errors = 0;      // failed bus reads
+	uint64_t overflows = 0;   // edges dropped because the edge queue was full
+	uint64_t watchdog = 0;    // status reads of the Data_Ready watchdog
+    };
+    ReadStats getReadStats() const;
+    void printReadStats() const;
+
+    static const char* modeName(TMP117Registers::Mode mode);
+    static const char* alertPinName(TMP117Registers::AlertPin pin);
+
     static constexpr double HIGH_THRESHOLD = 30.0;
     static constexpr double LOW_THRESHOLD = 15.0;
 
+    // priority of the temperature alarm on the shared buzzer, above the motion alarm
+    static constexpr int BUZZER_PRIORITY = 2;
+    // distance back inside a limit before the temperature alarm clears, in °C
+    static constexpr double ALARM_HYSTERESIS = 0.5;
+    // least time between two raises of an alarm, a value swinging across a limit sounds once a minute
+    static constexpr std::chrono::seconds ALARM_REARM{60};
+    // default window of the rate of change, and the fraction of the rate limit it must drop below to clear
+    static constexpr std::chrono::seconds RATE_WINDOW{60};
+    static constexpr double RATE_HYSTERESIS = 0.25;
+
 private:
     int sensor_id; // to uniquely identify the TMP117 sensor instance
-    Buzzer* buzzer;
+    TMP117Registers registers; // typed register access on the shared I2C bus session
+    AlarmManager* alarms;
+    int alarmSource = -1;
+    int rateAlarmSource = -1;
+
+    // rate of change of the reported temperatures, guarded by rate_mtx
+    RateOfChange rate{RATE_WINDOW};
+    double rateLimit = 0;
+    std::mutex rate_mtx;
     SensorMsgPublisher* msgPublisher;
     SensorMsg message;
+    std::mutex report_mtx; // message is shared by the processing thread and sample()
+
+    /**
+     * Edges recorded by hasEvent() on the GPIO event thread and handled by the processing
+     * thread (single producer, single consumer).
+     */
+    struct Edge {
+	int eventType;
+	int64_t timestampNs;
+    };
+    static constexpr size_t EDGE_QUEUE_SIZE = 64;
+    SPSCQueue<Edge, EDGE_QUEUE_SIZE> edges;
+    std::thread processingThread;
+    std::mutex processing_mtx;
+    std::condition_variable processing_cv;
+    std::atomic<bool> processingWaiting{false};
+    bool processingRunning = false;
+    ThreadConfig threadConfig;
+
+    // thresholds and conversion settings, guarded by config_mtx
+    double lowThreshold = LOW_THRESHOLD;
+    double highThreshold = HIGH_THRESHOLD;
+    TMP117Registers::ConversionSettings conversion;
+    TMP117Registers::AlertPin alertPin = TMP117Registers::PIN_DATA_READY;
+    bool initialized = false;
+    std::mutex config_mtx;
+
+    // read path counters and wall clock time of the last conversion read
+    std::atomic<uint64_t> nFresh{0}, nDuplicates{0}, nMissed{0}, nReadErrors{0}, nOverflows{0}, nWatchdog{0};
+    std::atomic<int64_t> lastConversionNs{0};
+    // monotonic deadline of the Data_Ready watchdog in ns, 0 = no conversion expected
+    std::atomic<int64_t> watchdogDueNs{0};
+
+    uint16_t configurationWord(TMP117Registers::Mode mode) const;
+    bool applyConfiguration();
+    bool applyLimits();
+
+    void startProcessing();
+    void processingWorker();
+    void process(const Edge& edge);
+    bool readStatus(uint16_t& config, double& temperature);
+    void handleDataReady(int64_t timestampNs);
+    void armWatchdog(bool oneShotTriggered);
+    void watchdog();
+    void handleLimitEvent(TMP117Registers::AlertPin pin, bool asserted, int64_t timestampNs);
+    void checkMissedConversions(int64_t edgeNs, int64_t readNs);
+    AlarmManager::Condition checkAlarm(double temperature, int64_t timestampNs);
+    void report(double temperature, int64_t timestampNs, AlarmManager::Condition alarm);
 };
 
 #endif // TMP117_TEMPERATURE_SENSOR_H
@@ -0,0 +1,226 @@
+/**
+ * ABOUT: Decoder of the binary log written by SAFE_PRINTF (BinaryLog.h). The running system only
+ * stores a format id, a monotonic timestamp and the raw arguments of each message; this tool
+ * formats them offline with the format strings the call sites registered in the same file, and
+ * prefixes every message with its wall clock time.
+ *
+ * Usage: ./binlog_decode [-r] <log file>
+ *     -r : raw, messages only, without the timestamps
+ * The file may be decoded while the system is still writing to it, the messages logged so far
+ * are printed.
+ */
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include "BinaryLog.h"
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+struct Format {
+    std::string signature;
+    std::string format;
+};
+
+/**
+ * Reads the arguments of one message in signature order.
+ */
+class ArgReader {
+public:
+    ArgReader(const char* p, const char* end) : p(p), end(end) {}
+
+    bool next(char tag, int64_t& i, uint64_t& u, double& d, std::string& s) {
+	switch (tag) {
+	case 'i': { int32_t v; if (!take(&v, sizeof(v))) return false; i = v; u = (uint32_t)v; return true; }
+	case 'I': { if (!take(&i, sizeof(i))) return false; u = i; return true; }
+	case 'u': { uint32_t v; if (!take(&v, sizeof(v))) return false; u = v; i = v; return true; }
+	case 'U': { if (!take(&u, sizeof(u))) return false; i = u; return true; }
+	case 'd': return take(&d, sizeof(d));
+	case 's': {
+	    uint16_t len;
+	    if (!take(&len, sizeof(len)) || end - p < len) return false;
+	    s.assign(p, len);
+	    p += len;
+	    return true;
+	}
+	}
+	return false;
+    }
+
+private:
+    const char* p;
+    const char* end;
+
+    bool take(void* v, size_t n) {
+	if ((size_t)(end - p) < n) return false;
+	memcpy(v, p, n);
+	p += n;
+	return true;
+    }
+};
+
+/**
+ * Renders a message: the text of the format is copied, each conversion is formatted with
+ * snprintf from the next argument, converted to the type the conversion expects.
+ */
+static std::string render(const Format& f, ArgReader args) {
+    std::string out;
+    const char* fmt = f.format.c_str();
+    size_t argNo = 0;
+    char buf[512];
+    while (*fmt) {
+	if (*fmt != '%') {
+	    out += *fmt++;
+	    continue;
+	}
+	if (fmt[1] == '%') {
+	    out += '%';
+	    fmt += 2;
+	    continue;
+	}
+	// %[flags][width][.precision][length]conversion, the length modifier is dropped
+	std::string spec = "%";
+	fmt++;
+	while (*fmt && strchr("-+ #0", *fmt)) spec += *fmt++;
+	while (*fmt && (isdigit((unsigned char)*fmt) || *fmt == '.')) spec += *fmt++;
+	while (*fmt && strchr("hlLqjzt", *fmt)) fmt++;
+	char conversion = *fmt;
+	if (!conversion) break;
+	fmt++;
+	if (argNo >= f.signature.size()) {
+	    out += "<missing>";
+	    continue;
+	}
+	int64_t i = 0;
+	uint64_t u = 0;
+	double d = 0;
+	std::string s;
+	char tag = f.signature[argNo++];
+	if (!args.next(tag, i, u, d, s)) return out + "<truncated>\n";
+	if (tag == 'd') i = (int64_t)d, u = (uint64_t)d;
+	else if (tag != 's') d = (tag == 'i' || tag == 'I') ? (double)i : (double)u;
+	switch (conversion) {
+	case 'c':
+	    spec += 'c';
+	    snprintf(buf, sizeof(buf), spec.c_str(), (int)i);
+	    break;
+	case 'd': case 'i':
+	    spec += "lld";
+	    snprintf(buf, sizeof(buf), spec.c_str(), (long long)i);
+	    break;
+	case 'u': case 'x': case 'X': case 'o':
+	    spec += "ll";
+	    spec += conversion;
+	    snprintf(buf, sizeof(buf), spec.c_str(), (unsigned long long)u);
+	    break;
+	case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+	    spec += conversion;
+	    snprintf(buf, sizeof(buf), spec.c_str(), d);
+	    break;
+	case 's':
+	    spec += 's';
+	    snprintf(buf, sizeof(buf), spec.c_str(), tag == 's' ? s.c_str() : "<not a string>");
+	    break;
+	case 'p':
+	    snprintf(buf, sizeof(buf), "0x%llx", (unsigned long long)u);
+	    break;
+	default:
+	    snprintf(buf, sizeof(buf), "<%%%c>", conversion);
+	}
+	out += buf;
+    }
+    return out;
+}
+
+int main(int argc, char* argv[]) {
+    bool raw = false;
+    const char* path = nullptr;
+    for (int a = 1; a < argc; a++) {
+	if (strcmp(argv[a], "-r") == 0) raw = true;
+	else path = argv[a];
+    }
+    if (!path) {
+	fprintf(stderr, "Usage: %s [-r] <log file>\n", argv[0]);
+	return 1;
+    }
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+	fprintf(stderr, "%s: %s\n", path, strerror(errno));
+	return 1;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    BinaryLog::FileHeader header;
+    if (data.size() < sizeof(header) || memcmp(data.data(), BinaryLog::MAGIC, sizeof(BinaryLog::MAGIC)) != 0) {
+	fprintf(stderr, "%s: not a binary log\n", path);
+	return 1;
+    }
+    memcpy(&header, data.data(), sizeof(header));
+
+    std::map<uint16_t, Format> formats;
+    size_t offset = sizeof(header);
+    uint64_t messages = 0;
+    while (offset + sizeof(BinaryLog::RecordHeader) <= data.size()) {
+	BinaryLog::RecordHeader record;
+	memcpy(&record, &data[offset], sizeof(record));
+	if (record.size == 0) break; // end of the log
+	if (record.size < sizeof(record) || offset + record.size > data.size()) {
+	    fprintf(stderr, "%s: corrupt record at offset %zu\n", path, offset);
+	    return 1;
+	}
+	const char* body = &data[offset + sizeof(record)];
+	const char* end = &data[offset] + record.size;
+	offset += record.size;
+
+	if (record.type == BinaryLog::FORMAT) {
+	    Format f;
+	    f.signature.assign(body, strnlen(body, end - body));
+	    const char* format = body + f.signature.size() + 1;
+	    if (format < end) f.format.assign(format, strnlen(format, end - format));
+	    formats[record.formatId] = f;
+	    continue;
+	}
+	if (record.type != BinaryLog::MESSAGE || (size_t)(end - body) < sizeof(uint64_t)) continue;
+	uint64_t monoNs;
+	memcpy(&monoNs, body, sizeof(monoNs));
+	auto it = formats.find(record.formatId);
+	if (it == formats.end()) {
+	    fprintf(stderr, "%s: message with unknown format id %u\n", path, record.formatId);
+	    continue;
+	}
+	std::string text = render(it->second, ArgReader(body + sizeof(monoNs), end));
+	messages++;
+	if (raw) {
+	    fputs(text.c_str(), stdout);
+	    continue;
+	}
+	// the messages end with "\n\r" and some start with a blank line: stamp the first text
+	int64_t wallNs = (int64_t)monoNs + header.realtimeOffsetNs;
+	time_t sec = wallNs / 1000000000LL;
+	struct tm tm;
+	localtime_r(&sec, &tm);
+	char stamp[48];
+	size_t n = strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm);
+	snprintf(stamp + n, sizeof(stamp) - n, ".%06lld ", (long long)(wallNs % 1000000000LL) / 1000);
+	size_t first = text.find_first_not_of("\n\r");
+	if (first == std::string::npos) first = text.size();
+	text.insert(first, stamp);
+	fputs(text.c_str(), stdout);
+    }
+    fprintf(stderr, "%llu messages, %zu formats, %llu dropped (log full), %zu of %llu bytes used\n",
+	    (unsigned long long)messages, formats.size(), (unsigned long long)header.dropped, offset,
+	    (unsigned long long)header.capacity);
+    return 0;
+}
@@ -0,0 +1,272 @@
+/**
+ * ABOUT: Edge rate stress benchmark for the GPIO pipeline on a simulated GPIO chip (GPIOSim,
+ * kernel gpio-sim module), so the edges come from the kernel with kernel timestamps exactly as
+ * on the target. Three groups of lines are driven at the same time:
+ * - plain lines toggled at a fixed rate, each with a GPIOPin and a counting inline callback:
+ *   the raw capacity of GPIOPin and the GPIOReactor
+ * - PIR lines toggled at the same rate, each with a MotionSensor set up as in smart_system
+ *   (POOL executor, queue of 4, MERGE_LATEST), raising their alarms on an AlarmManager with a
+ *   Buzzer on another simulated line
+ * - TMP117 ALERT lines driven by simulated TMP117s (SimulatedTMP117.h) on simulated I2C buses,
+ *   each with a GPIOPin and a TMP117TemperatureSensor reading and publishing the conversions
+ * For each group it reports the edge rates generated, read and delivered to the callbacks, the
+ * edges lost on the way (kernel queue overflows, callback queue drops and merges) and the
+ * latency from the kernel timestamp of the edges to the start and the return of the callbacks.
+ *
+ * Usage: sudo ./gpio_edge_benchmark [lines] [edges/s per line] [seconds] [PIRs] [TMP117s] [time scale] > /dev/null
+ *     lines      : plain lines (default 8)
+ *     edges/s    : toggle rate of each plain and PIR line (default 1000)
+ *     seconds    : duration of the run (default 5)
+ *     PIRs       : PIR lines (default 1)
+ *     TMP117s    : simulated TMP117 sensors, 4 per simulated bus (default 4)
+ *     time scale : speed-up of the simulated conversions (default 16)
+ * Needs root and gpio-sim ("modprobe gpio-sim"). The per event log goes to stdout, the
+ * benchmark report to stderr.
+ */
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include "GPIOSim.h"
+#include "gpioevent.h"
+#include "buzzer.h"
+#include "AlarmManager.h"
+#include "MotionSensor.h"
+#include "I2CBus.h"
+#include "SimulatedTMP117.h"
+#include "TMP117TemperatureSensor.h"
+#include "SensorMsgPublisher.h"
+#include "TimestampService.h"
+#include "LatencyHistogram.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <time.h>
+
+#define SENSORS_PER_BUS 4
+#define TMP117_FIRST_ADDR 0x48
+
+// does nothing but count, so that the plain lines measure GPIOPin itself
+class EdgeCounter : public GPIOPin::GPIOEventCallbackInterface {
+public:
+    void hasEvent(gpiod_line_event&) override { n++; }
+    std::atomic<uint64_t> n{0};
+};
+
+/**
+ * Lines of one kind and the edges generated on them.
+ */
+struct Group {
+    const char* name;
+    std::vector<std::unique_ptr<GPIOPin>> pins;
+    std::atomic<uint64_t> generated{0};
+    std::atomic<uint64_t> generatorErrors{0};
+
+    explicit Group(const char* name) : name(name) {}
+
+    void report(double secs) {
+	if (pins.empty()) return;
+	uint64_t events = 0, lost = 0, fullReads = 0, drops = 0, merges = 0, maxBurst = 0;
+	LatencyHistogram dispatch, handled;
+	for (auto& pin : pins) {
+	    GPIOPin::Stats s = pin->getStats();
+	    events += s.events;
+	    lost += s.lostEdges;
+	    fullReads += s.fullReads;
+	    drops += s.callbackDrops;
+	    merges += s.callbackMerges;
+	    if (s.maxBurst > maxBurst) maxBurst = s.maxBurst;
+	    dispatch.add(pin->getDispatchLatency());
+	    handled.add(pin->getHandledLatency());
+	}
+	uint64_t delivered = handled.count();
+	uint64_t gen = generated;
+	fprintf(stderr, "%-7s : %zu line(s), %9.0f edges/s generated, %9.0f read, %9.0f delivered; "
+		"lost %llu (%.2f%%), kernel lost %llu, full reads %llu, max burst %llu, callback drops %llu, merges %llu",
+		name, pins.size(), gen / secs, events / secs, delivered / secs,
+		(unsigned long long)(gen > delivered ? gen - delivered : 0), gen ? 100.0 * (gen > delivered ? gen - delivered : 0) / gen : 0.0,
+		(unsigned long long)lost, (unsigned long long)fullReads, (unsigned long long)maxBurst,
+		(unsigned long long)drops, (unsigned long long)merges);
+	if (generatorErrors) fprintf(stderr, ", %llu failed pulls", (unsigned long long)generatorErrors.load());
+	fprintf(stderr, "\n");
+	LatencyHistogram::Summary d = dispatch.summary();
+	LatencyHistogram::Summary h = handled.summary();
+	fprintf(stderr, "          edge to callback start  : p50 %7.1f us, p99 %7.1f us, p99.9 %7.1f us, max %8.1f us\n",
+		d.p50 / 1e3, d.p99 / 1e3, d.p999 / 1e3, d.max / 1e3);
+	fprintf(stderr, "          edge to callback return : p50 %7.1f us, p99 %7.1f us, p99.9 %7.1f us, max %8.1f us\n",
+		h.p50 / 1e3, h.p99 / 1e3, h.p999 / 1e3, h.max / 1e3);
+    }
+};
+
+/**
+ * Toggles the given lines round robin so that each changes rate times per second, on an
+ * absolute schedule: if pulling the lines can't keep up, the generated rate shows it.
+ */
+static void generate(GPIOSim* sim, std::vector<std::pair<int, Group*>> lines, double rate,
+		     std::atomic<bool>* running) {
+    if (lines.empty() || rate <= 0) return;
+    std::vector<int> levels(lines.size(), 0);
+    int64_t intervalNs = (int64_t)(1e9 / (rate * lines.size()));
+    int64_t next = TimestampService::monotonicNow();
+    size_t i = 0;
+    while (running->load(std::memory_order_relaxed)) {
+	next += intervalNs;
+	timespec ts = { (time_t)(next / TimestampService::NS_PER_SEC), (long)(next % TimestampService::NS_PER_SEC) };
+	clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+	levels[i] = !levels[i];
+	Group* group = lines[i].second;
+	if (sim->setLevel(lines[i].first, levels[i])) group->generated++;
+	else group->generatorErrors++;
+	i = (i + 1) % lines.size();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int nPlain = argc > 1 ? atoi(argv[1]) : 8;
+    double rate = argc > 2 ? atof(argv[2]) : 1000;
+    double seconds = argc > 3 ? atof(argv[3]) : 5;
+    int nPIR = argc > 4 ? atoi(argv[4]) : 1;
+    int nSensors = argc > 5 ? atoi(argv[5]) : 4;
+    double timeScale = argc > 6 ? atof(argv[6]) : 16;
+    if (nPlain < 0 || nPIR < 0 || nSensors < 0 || nPlain + nPIR + nSensors == 0 || rate < 0 || seconds <= 0 || timeScale <= 0) {
+	fprintf(stderr, "Usage: %s [lines] [edges/s per line] [seconds] [PIRs] [TMP117s] [time scale]\n", argv[0]);
+	return 1;
+    }
+
+    // plain lines, then PIR lines, then TMP117 ALERT lines, then the buzzer
+    int firstPIR = nPlain;
+    int firstSensor = firstPIR + nPIR;
+    int buzzerLine = firstSensor + nSensors;
+    GPIOSim sim(buzzerLine + 1, "gpio-edge-benchmark");
+    if (!sim.isLive()) {
+	fprintf(stderr, "gpio-sim chip could not be created, run as root after \"modprobe gpio-sim\"\n");
+	return 1;
+    }
+    int chip = sim.getChipNumber();
+
+    SensorMsgPublisher pub;
+    if (nSensors > 0 && !pub.init()) {
+	fprintf(stderr, "Publisher could not be initialised\n");
+	return 1;
+    }
+
+    Group plain("plain"), pir("PIR"), tmp117("TMP117");
+
+    std::vector<std::unique_ptr<EdgeCounter>> counters;
+    for (int i = 0; i < nPlain; i++) {
+	EdgeCounter* counter = new EdgeCounter();
+	counters.emplace_back(counter);
+	GPIOPin* pin = new GPIOPin();
+	plain.pins.emplace_back(pin);
+	pin->registerCallback(counter);
+	pin->start(i, chip, "edge benchmark");
+    }
+
+    Buzzer buzzer(chip, buzzerLine);
+    AlarmManager alarms(&buzzer);
+    std::vector<std::unique_ptr<MotionSensor>> motionSensors;
+    GPIOPin::CallbackOptions motionOptions;
+    motionOptions.executor = GPIOPin::POOL;
+    motionOptions.queueSize = 4;
+    motionOptions.overflow = GPIOPin::MERGE_LATEST;
+    for (int i = 0; i < nPIR; i++) {
+	MotionSensor* motion = new MotionSensor(&alarms, "PIR " + std::to_string(i + 1));
+	motionSensors.emplace_back(motion);
+	GPIOPin* pin = new GPIOPin();
+	pir.pins.emplace_back(pin);
+	pin->registerCallback(motion, motionOptions);
+	pin->start(firstPIR + i, chip, "edge benchmark PIR");
+    }
+
+    // simulated TMP117s, their ALERT pins drive the simulated lines
+    std::vector<SimulatedTMP117Transport*> sims;
+    std::vector<std::unique_ptr<I2CBus>> buses;
+    int nBuses = (nSensors + SENSORS_PER_BUS - 1) / SENSORS_PER_BUS;
+    for (int b = 0; b < nBuses; b++) {
+	SimulatedTMP117Transport* bus = new SimulatedTMP117Transport(timeScale, "simulated bus " + std::to_string(b));
+	sims.push_back(bus);
+	buses.emplace_back(new I2CBus(std::unique_ptr<I2CTransport>(bus)));
+	bus->setAlertCallback([&sim, &tmp117, firstSensor, b](uint8_t addr, int level, int64_t) {
+	    if (sim.setLevel(firstSensor + b * SENSORS_PER_BUS + addr - TMP117_FIRST_ADDR, level)) tmp117.generated++;
+	    else tmp117.generatorErrors++;
+	});
+    }
+    TMP117Registers::ConversionSettings fastest;
+    fastest.cycle = 0;
+    fastest.averaging = TMP117Registers::AVG_1;
+    std::vector<std::unique_ptr<TMP117TemperatureSensor>> sensors;
+    for (int i = 0; i < nSensors; i++) {
+	uint8_t addr = TMP117_FIRST_ADDR + i % SENSORS_PER_BUS;
+	sims[i / SENSORS_PER_BUS]->addDevice(addr);
+	// the ALERT pin idles high (active low)
+	sim.setLevel(firstSensor + i, 1);
+	// no buzzer, thresholds out of reach so that the run is not stalled by alarms
+	TMP117TemperatureSensor* sensor = new TMP117TemperatureSensor(i + 1, nullptr, *buses[i / SENSORS_PER_BUS], addr);
+	sensor->setThresholds(-100, 150);
+	sensor->setConversion(fastest);
+	sensor->setSensorMsgPublisher(&pub);
+	sensor->onTemperatureRead = [](double, int64_t) {};
+	sensors.emplace_back(sensor);
+	if (!sensor->initialize()) {
+	    fprintf(stderr, "Sensor %d could not be initialized\n", i + 1);
+	    exit(1); // the pins of the sensors before are already dispatching
+	}
+	GPIOPin* pin = new GPIOPin();
+	tmp117.pins.emplace_back(pin);
+	pin->registerCallback(sensor);
+	pin->start(firstSensor + i, chip, "edge benchmark TMP117");
+    }
+
+    std::vector<std::pair<int, Group*>> driven;
+    for (int i = 0; i < nPlain; i++) driven.push_back({ i, &plain });
+    for (int i = 0; i < nPIR; i++) driven.push_back({ firstPIR + i, &pir });
+
+    fprintf(stderr, "GPIO edge benchmark on gpiochip%d: %d plain and %d PIR line(s) at %.0f edges/s each, "
+	    "%d TMP117 sensor(s) at %.0f conversions/s each, %.1f s\n",
+	    chip, nPlain, nPIR, rate, nSensors,
+	    timeScale * 1e6 / TMP117Registers::cycleTimeUs(fastest.cycle, fastest.averaging), seconds);
+
+    std::atomic<bool> running{true};
+    auto start = std::chrono::steady_clock::now();
+    for (auto* bus : sims) bus->start();
+    std::thread generator(generate, &sim, driven, rate, &running);
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    running = false;
+    generator.join();
+    for (auto* bus : sims) bus->stop();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // edges still in flight are delivered before the lines are released
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    for (auto& sensor : sensors) sensor->stop();
+    for (auto* bus : sims) bus->setAlertCallback(nullptr);
+    for (Group* group : { &plain, &pir, &tmp117 }) {
+	for (auto& pin : group->pins) pin->stop();
+    }
+
+    plain.report(secs);
+    pir.report(secs);
+    tmp117.report(secs);
+    if (nSensors > 0) {
+	uint64_t reported = 0, errors = 0;
+	for (auto& sensor : sensors) {
+	    TMP117TemperatureSensor::ReadStats s = sensor->getReadStats();
+	    reported += s.fresh;
+	    errors += s.errors;
+	}
+	uint64_t conversions = 0;
+	for (auto* bus : sims) conversions += bus->getStats().conversions;
+	fprintf(stderr, "          %.0f samples/s reported of %.0f conversions/s, %llu read errors\n",
+		reported / secs, conversions / secs, (unsigned long long)errors);
+    }
+    return 0;
+}
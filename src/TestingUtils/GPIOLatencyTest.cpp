@@ -0,0 +1,158 @@
+/**
+ * ABOUT: Latency test mode for the real-time settings of the acquisition threads (ThreadConfig).
+ * A periodic timerfd is watched by the GPIOReactor exactly like the event fd of a GPIO line, and
+ * the delay from each expiry to its handler on the reactor thread is recorded: the wakeup latency
+ * every edge of the alarm path pays before its timestamp is even looked at. Load threads keep all
+ * CPUs busy and churn memory meanwhile, as the GUI replots and the camera do on the target.
+ *
+ * The test runs twice, first with normal scheduling, then with the given settings applied to the
+ * running reactor thread (SCHED_FIFO, affinity, stack prefault) and the process memory locked,
+ * and reports the jitter of both runs.
+ *
+ * Usage: sudo ./gpio_latency_test [seconds] [period us] [priority] [cpus] [load threads]
+ *     seconds      : duration of each run (default 10)
+ *     period us    : timer period (default 1000)
+ *     priority     : SCHED_FIFO priority of the second run (default 80)
+ *     cpus         : CPUs of the reactor thread in the second run, e.g. 3 or 2-3 (default any)
+ *     load threads : busy threads (default one per CPU)
+ * Without root (or CAP_SYS_NICE / CAP_IPC_LOCK) the settings fail with an error and both runs
+ * measure normal scheduling.
+ */
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include "GPIOReactor.h"
+#include "LatencyHistogram.h"
+#include "ThreadConfig.h"
+#include "TimestampService.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#define LOAD_BUFFER_SIZE (4 << 20)
+
+/**
+ * Periodic timer dispatched by the reactor, records how late each expiry was handled.
+ */
+class TimerProbe : public GPIOReactor::Handler {
+public:
+    explicit TimerProbe(int64_t periodNs) : periodNs(periodNs) {
+	fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    }
+    ~TimerProbe() {
+	if (fd >= 0) close(fd);
+    }
+
+    bool start(LatencyHistogram* histogram) {
+	latency = histogram;
+	firstNs = TimestampService::monotonicNow() + periodNs;
+	expiries = 0;
+	overruns = 0;
+	itimerspec spec = {};
+	spec.it_value.tv_sec = firstNs / TimestampService::NS_PER_SEC;
+	spec.it_value.tv_nsec = firstNs % TimestampService::NS_PER_SEC;
+	spec.it_interval.tv_sec = periodNs / TimestampService::NS_PER_SEC;
+	spec.it_interval.tv_nsec = periodNs % TimestampService::NS_PER_SEC;
+	if (fd < 0 || timerfd_settime(fd, TFD_TIMER_ABSTIME, &spec, nullptr) < 0) return false;
+	return GPIOReactor::get().add(fd, this);
+    }
+
+    void stop() {
+	GPIOReactor::get().remove(fd);
+	itimerspec off = {};
+	timerfd_settime(fd, 0, &off, nullptr);
+    }
+
+    uint64_t getOverruns() const { return overruns; }
+
+    void onReadable(int) override {
+	int64_t now = TimestampService::monotonicNow();
+	uint64_t n;
+	if (read(fd, &n, sizeof(n)) != sizeof(n)) return;
+	// expiries handled that late that the next one has passed are counted once, as overruns
+	if (n > 1) overruns += n - 1;
+	expiries += n;
+	latency->record(now - (firstNs + (int64_t)(expiries - 1) * periodNs));
+    }
+
+private:
+    int fd;
+    int64_t periodNs;
+    int64_t firstNs = 0;
+    uint64_t expiries = 0;
+    uint64_t overruns = 0;
+    LatencyHistogram* latency = nullptr;
+};
+
+// keeps one CPU busy and its caches and TLB dirty
+static void load(std::atomic<bool>* running) {
+    std::unique_ptr<char[]> buffer(new char[LOAD_BUFFER_SIZE]);
+    unsigned pass = 0;
+    while (running->load(std::memory_order_relaxed)) {
+	memset(buffer.get(), pass++, LOAD_BUFFER_SIZE);
+	// short lived allocations as a GUI makes them
+	std::vector<double> samples(4096, pass);
+	if (samples[pass % samples.size()] < 0) break;
+    }
+}
+
+static void run(const char* label, TimerProbe& probe, double seconds, LatencyHistogram& latency) {
+    if (!probe.start(&latency)) {
+	fprintf(stderr, "%s : timer could not be started: %s\n", label, strerror(errno));
+	return;
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    probe.stop();
+    LatencyHistogram::Summary s = latency.summary();
+    fprintf(stderr, "%-8s : p50 %7.1f us, p99 %7.1f us, p99.9 %7.1f us, max %8.1f us, jitter %8.1f us (%llu wakeups, %llu overruns)\n",
+	    label, s.p50 / 1e3, s.p99 / 1e3, s.p999 / 1e3, s.max / 1e3, (s.max - s.p50) / 1e3,
+	    (unsigned long long)s.count, (unsigned long long)probe.getOverruns());
+}
+
+int main(int argc, char* argv[]) {
+    double seconds = argc > 1 ? atof(argv[1]) : 10;
+    long periodUs = argc > 2 ? atol(argv[2]) : 1000;
+    ThreadConfig rt;
+    rt.priority = argc > 3 ? atoi(argv[3]) : 80;
+    rt.prefaultStack = 64 * 1024;
+    bool cpusOk = argc > 4 ? rt.parseCpus(argv[4]) : true;
+    int nLoad = argc > 5 ? atoi(argv[5]) : std::thread::hardware_concurrency();
+    if (seconds <= 0 || periodUs <= 0 || rt.priority < 1 || rt.priority > 99 || !cpusOk || nLoad < 0) {
+	fprintf(stderr, "Usage: %s [seconds] [period us] [priority] [cpus] [load threads]\n", argv[0]);
+	return 1;
+    }
+
+    fprintf(stderr, "GPIO reactor wakeup latency: %.1f s per run, period %ld us, %d load thread(s)\n",
+	    seconds, periodUs, nLoad);
+
+    std::atomic<bool> running{true};
+    std::vector<std::thread> loadThreads;
+    for (int i = 0; i < nLoad; i++) loadThreads.emplace_back(load, &running);
+
+    TimerProbe probe(periodUs * 1000LL);
+    LatencyHistogram normal, realtime;
+    run("normal", probe, seconds, normal);
+
+    fprintf(stderr, "applying %s and locking the process memory\n", rt.describe().c_str());
+    ThreadConfig::lockMemory();
+    GPIOReactor::get().setThreadConfig(rt);
+    run("realtime", probe, seconds, realtime);
+
+    running = false;
+    for (auto& t : loadThreads) t.join();
+    return 0;
+}
@@ -0,0 +1,213 @@
+/**
+ * ABOUT: Benchmark for the whole TMP117 acquisition pipeline without hardware.
+ * Simulated TMP117s (SimulatedTMP117.h) convert at an accelerated rate and toggle their ALERT
+ * pin; each pin is served by its own event thread as a GPIOPin would, which calls
+ * TMP117TemperatureSensor::hasEvent(). The sensor queues the edge to its processing thread,
+ * which reads status and result over the I2CBus session, reports the sample and publishes
+ * it with the SensorMsgPublisher.
+ *
+ * Usage: ./tmp117_pipeline_benchmark [sensors] [time scale] [seconds] [noise °C] [error rate] > /dev/null
+ *     sensors    : number of sensors, 4 per simulated bus (default 4)
+ *     time scale : speed-up of the simulated conversions (default 64)
+ *     seconds    : duration of the run (default 5)
+ *     noise      : standard deviation of the simulated results (default 0.05)
+ *     error rate : probability of a failed bus transaction (default 0)
+ * The sensors run with the shortest conversion cycle (15.5 ms). The per sample log goes to
+ * stdout, the benchmark report to stderr. The sensors detect missed conversions from the
+ * nominal conversion cycle, so their "missed" count is only meaningful at time scale 1; the
+ * simulation counts the conversions overwritten unread at any time scale.
+ */
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include "I2CBus.h"
+#include "SimulatedTMP117.h"
+#include "TMP117TemperatureSensor.h"
+#include "SensorMsgPublisher.h"
+#include "TimestampService.h"
+#include "LatencyHistogram.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define SENSORS_PER_BUS 4
+#define TMP117_FIRST_ADDR 0x48
+
+/**
+ * Event thread of one simulated ALERT line: the simulation posts the pin changes and the
+ * thread delivers them to the sensor, as the GPIOReactor thread dispatches the edges read from
+ * the event fd of a real line to the GPIOPin callbacks.
+ */
+class SimulatedPin {
+public:
+    explicit SimulatedPin(GPIOPin::GPIOEventCallbackInterface* cb) : cb(cb) {
+	thr = std::thread(&SimulatedPin::worker, this);
+    }
+    ~SimulatedPin() {
+	{
+	    std::lock_guard<std::mutex> lock(mtx);
+	    running = false;
+	}
+	cv.notify_one();
+	thr.join();
+    }
+
+    void post(int level, int64_t monotonicNs) {
+	gpiod_line_event e;
+	e.event_type = level ? GPIOD_LINE_EVENT_RISING_EDGE : GPIOD_LINE_EVENT_FALLING_EDGE;
+	e.ts.tv_sec = monotonicNs / TimestampService::NS_PER_SEC;
+	e.ts.tv_nsec = monotonicNs % TimestampService::NS_PER_SEC;
+	{
+	    std::lock_guard<std::mutex> lock(mtx);
+	    events.push_back(e);
+	}
+	cv.notify_one();
+    }
+
+private:
+    GPIOPin::GPIOEventCallbackInterface* cb;
+    std::deque<gpiod_line_event> events;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::thread thr;
+    bool running = true;
+
+    void worker() {
+	std::unique_lock<std::mutex> lock(mtx);
+	while (running || !events.empty()) {
+	    if (events.empty()) {
+		cv.wait(lock);
+		continue;
+	    }
+	    gpiod_line_event e = events.front();
+	    events.pop_front();
+	    lock.unlock();
+	    cb->hasEvent(e);
+	    lock.lock();
+	}
+    }
+};
+
+int main(int argc, char* argv[]) {
+    int nSensors = argc > 1 ? atoi(argv[1]) : 4;
+    double timeScale = argc > 2 ? atof(argv[2]) : 64;
+    double seconds = argc > 3 ? atof(argv[3]) : 5;
+    double noise = argc > 4 ? atof(argv[4]) : 0.05;
+    double errorRate = argc > 5 ? atof(argv[5]) : 0;
+    if (nSensors < 1 || timeScale <= 0 || seconds <= 0) {
+	fprintf(stderr, "Usage: %s [sensors] [time scale] [seconds] [noise °C] [error rate]\n", argv[0]);
+	return 1;
+    }
+
+    SensorMsgPublisher pub;
+    if (!pub.init()) {
+	fprintf(stderr, "Publisher could not be initialised\n");
+	return 1;
+    }
+
+    // one simulated bus per 4 sensors, the buses own their simulation
+    std::vector<SimulatedTMP117Transport*> sims;
+    std::vector<std::unique_ptr<I2CBus>> buses;
+    int nBuses = (nSensors + SENSORS_PER_BUS - 1) / SENSORS_PER_BUS;
+    for (int b = 0; b < nBuses; b++) {
+	SimulatedTMP117Transport* sim = new SimulatedTMP117Transport(timeScale, "simulated bus " + std::to_string(b));
+	sims.push_back(sim);
+	buses.emplace_back(new I2CBus(std::unique_ptr<I2CTransport>(sim)));
+    }
+
+    TMP117Registers::ConversionSettings fastest;
+    fastest.cycle = 0;
+    fastest.averaging = TMP117Registers::AVG_1;
+
+    std::vector<std::unique_ptr<TMP117TemperatureSensor>> sensors;
+    // edge to report latency of each sensor
+    std::vector<std::unique_ptr<LatencyHistogram>> latencies;
+    for (int i = 0; i < nSensors; i++) {
+	uint8_t addr = TMP117_FIRST_ADDR + i % SENSORS_PER_BUS;
+	SimulatedTMP117Transport::DeviceModel model;
+	model.noise = noise;
+	model.profile = [i](double t) { return 22.0 + i + 2.0 * sin(t / 60.0); };
+	sims[i / SENSORS_PER_BUS]->addDevice(addr, model);
+
+	// no buzzer, thresholds out of reach so that the run is not stalled by alarms
+	TMP117TemperatureSensor* sensor = new TMP117TemperatureSensor(i + 1, nullptr, *buses[i / SENSORS_PER_BUS], addr);
+	sensor->setThresholds(-100, 150);
+	sensor->setConversion(fastest);
+	sensor->setSensorMsgPublisher(&pub);
+	LatencyHistogram* latency = new LatencyHistogram();
+	sensor->onTemperatureRead = [latency](double, int64_t timestampNs) {
+	    latency->record(TimestampService::get().now() - timestampNs);
+	};
+	sensors.emplace_back(sensor);
+	latencies.emplace_back(latency);
+	if (!sensor->initialize()) {
+	    fprintf(stderr, "Sensor %d could not be initialized\n", i + 1);
+	    return 1;
+	}
+    }
+    // errors only on the read path, a sensor left unconfigured would just report nothing
+    for (auto* sim : sims) sim->setErrorRate(errorRate);
+
+    std::vector<std::unique_ptr<SimulatedPin>> pins;
+    for (int i = 0; i < nSensors; i++) pins.emplace_back(new SimulatedPin(sensors[i].get()));
+    for (int b = 0; b < nBuses; b++) {
+	sims[b]->setAlertCallback([&pins, b](uint8_t addr, int level, int64_t ns) {
+	    pins[b * SENSORS_PER_BUS + addr - TMP117_FIRST_ADDR]->post(level, ns);
+	});
+    }
+
+    fprintf(stderr, "TMP117 pipeline benchmark: %d sensor(s) on %d simulated bus(es), time scale %.0f, "
+	    "%.0f conversions/s per sensor, %.1f s\n",
+	    nSensors, nBuses, timeScale,
+	    timeScale * 1e6 / TMP117Registers::cycleTimeUs(fastest.cycle, fastest.averaging), seconds);
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto* sim : sims) sim->start();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    for (auto* sim : sims) sim->stop();
+    // handles the queued edges, their reads still toggle the pins until the sensors are stopped
+    for (auto& sensor : sensors) sensor->stop();
+    for (auto* sim : sims) sim->setAlertCallback(nullptr);
+    pins.clear();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t conversions = 0, overwritten = 0, reported = 0;
+    for (auto* sim : sims) {
+	SimulatedTMP117Transport::Stats s = sim->getStats();
+	conversions += s.conversions;
+	overwritten += s.overwritten;
+    }
+    for (int i = 0; i < nSensors; i++) {
+	TMP117TemperatureSensor::ReadStats s = sensors[i]->getReadStats();
+	LatencyHistogram::Summary l = latencies[i]->summary();
+	reported += s.fresh;
+	fprintf(stderr, "sensor %d : %8.0f samples/s, duplicates %llu, missed %llu, errors %llu, overflows %llu, watchdog %llu, "
+		"latency p50 %.1f us p99 %.1f us p99.9 %.1f us max %.1f us\n",
+		i + 1, s.fresh / secs, (unsigned long long)s.duplicates, (unsigned long long)s.missed,
+		(unsigned long long)s.errors, (unsigned long long)s.overflows, (unsigned long long)s.watchdog,
+		l.p50 / 1e3, l.p99 / 1e3, l.p999 / 1e3, l.max / 1e3);
+    }
+    fprintf(stderr, "total    : %8.0f samples/s reported of %.0f conversions/s, %llu conversions overwritten unread\n",
+	    reported / secs, conversions / secs, (unsigned long long)overwritten);
+    for (auto& bus : buses) {
+	I2CBus::Stats s = bus->getStats();
+	fprintf(stderr, "%s : transfers %llu, coalesced %llu, errors %llu, utilisation %.3f%%\n",
+		bus->getDevicePath().c_str(), (unsigned long long)s.transfers, (unsigned long long)s.coalesced,
+		(unsigned long long)s.errors, s.utilisation() * 100.0);
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+/**
+ * ABOUT: Benchmark for the TMP117 temperature read path.
+ * Measures reads per second of
+ * (1) the legacy sequence : open(), ioctl(I2C_SLAVE), write(pointer), usleep(1000), read(2), close()
+ * (2) the session path    : one combined I2C_RDWR transaction on a long-lived I2CBus
+ * (3) the session path with several sensor threads reading concurrently, where the
+ *     bus thread coalesces the queued reads into shared I2C_RDWR transactions
+ *
+ * Without arguments all paths run against the in-process TMP117 model (SimulatedTMP117.h),
+ * so the benchmark can run on any Linux box. With a bus device and address, e.g.
+ *     ./tmp117_read_benchmark /dev/i2c-1 0x48
+ * all paths run against the real sensor.
+ */
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include "I2CBus.h"
+#include "SimulatedTMP117.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <linux/i2c-dev.h>
+#include <sys/ioctl.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#define TMP117_TEMP_REG 0x00
+#define SECONDS_PER_RUN 2
+#define CONCURRENT_READERS 8
+#define STR(x) #x
+#define TO_STR(x) STR(x)
+
+// Legacy path on the simulation: two separate transactions with the 1 ms settle delay in between
+static bool legacySimulatedRead(SimulatedTMP117Transport& sim, uint8_t addr, uint8_t* buffer) {
+    uint8_t reg = TMP117_TEMP_REG;
+    i2c_msg w = { addr, 0, 1, &reg };
+    if (sim.transfer(&w, 1) != 1) return false;
+    usleep(1000);
+    i2c_msg r = { addr, I2C_M_RD, 2, buffer };
+    return sim.transfer(&r, 1) == 1;
+}
+
+// Legacy path on real hardware, identical to the pre-session TMP117TemperatureSensor::readTemperature()
+static bool legacyDeviceRead(const char* device, uint8_t addr, uint8_t* buffer) {
+    int fd = open(device, O_RDWR);
+    if (fd < 0) return false;
+    if (ioctl(fd, I2C_SLAVE, addr) < 0) { close(fd); return false; }
+    unsigned char reg = TMP117_TEMP_REG;
+    if (write(fd, &reg, 1) != 1) { close(fd); return false; }
+    usleep(1000);
+    bool ok = ::read(fd, buffer, 2) == 2;
+    close(fd);
+    return ok;
+}
+
+static void run(const char* name, std::function<bool(uint8_t*)> readOnce, int nThreads = 1) {
+    std::atomic<long> reads{0}, errors{0};
+    std::atomic<int16_t> last{0};
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::seconds(SECONDS_PER_RUN);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nThreads; t++) {
+	threads.emplace_back([&]() {
+	    uint8_t buffer[2];
+	    while (std::chrono::steady_clock::now() < deadline) {
+		if (readOnce(buffer)) reads++; else errors++;
+	    }
+	    last = (buffer[0] << 8) | buffer[1];
+	});
+    }
+    for (auto& t : threads) t.join();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%-10s : %10.0f reads/s  %8.2f us/read  errors %ld  last %.4f °C\n",
+	   name, reads / secs, secs * 1e6 / (reads ? reads.load() : 1), errors.load(), last * 0.0078125);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 3) {
+	const char* device = argv[1];
+	uint8_t addr = strtol(argv[2], nullptr, 0);
+	printf("TMP117 read benchmark on %s address 0x%02X\n", device, addr);
+	I2CBus bus(device);
+	run("legacy", [&](uint8_t* b) { return legacyDeviceRead(device, addr, b); });
+	run("session", [&](uint8_t* b) { return bus.readRegister(addr, TMP117_TEMP_REG, b, 2); });
+	run("session x" TO_STR(CONCURRENT_READERS), [&](uint8_t* b) { return bus.readRegister(addr, TMP117_TEMP_REG, b, 2); }, CONCURRENT_READERS);
+	bus.printStats();
+    } else {
+	const uint8_t addr = 0x48;
+	printf("TMP117 read benchmark on simulated TMP117 at address 0x%02X\n", addr);
+	SimulatedTMP117Transport* sim = new SimulatedTMP117Transport();
+	sim->addDevice(addr);
+	I2CBus bus{std::unique_ptr<I2CTransport>(sim)}; // the bus owns the simulation
+	run("legacy", [&](uint8_t* b) { return legacySimulatedRead(*sim, addr, b); });
+	run("session", [&](uint8_t* b) { return bus.readRegister(addr, TMP117_TEMP_REG, b, 2); });
+	run("session x" TO_STR(CONCURRENT_READERS), [&](uint8_t* b) { return bus.readRegister(addr, TMP117_TEMP_REG, b, 2); }, CONCURRENT_READERS);
+	bus.printStats();
+    }
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include "ThreadConfig.h"
+#include "SafePrint.h" //safe printf in multi-threaded environment
+#include <alloca.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// touches one byte per page of bytes of stack below the caller, never inlined so the frame is released again
+static void __attribute__((noinline)) prefault(size_t bytes) {
+	volatile char* stack = (volatile char*)alloca(bytes);
+	long page = sysconf(_SC_PAGESIZE);
+	for (size_t i = 0; i < bytes; i += page) stack[i] = 0;
+}
+
+// bytes of stack left below the caller, minus a margin for the frames still to come
+static size_t freeStack() {
+	pthread_attr_t attr;
+	if (pthread_getattr_np(pthread_self(), &attr) != 0) return 0;
+	void* base;
+	size_t size;
+	int r = pthread_attr_getstack(&attr, &base, &size);
+	pthread_attr_destroy(&attr);
+	if (r != 0) return 0;
+	const size_t margin = 64 * 1024;
+	char here;
+	size_t below = &here - (char*)base; // the stack grows down towards base
+	return below > margin ? below - margin : 0;
+}
+
+bool ThreadConfig::apply(const char* name) const {
+	bool ok = true;
+	char shortName[16];
+	snprintf(shortName, sizeof(shortName), "%s", name);
+	pthread_setname_np(pthread_self(), shortName);
+
+	if (!cpus.empty()) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (int cpu : cpus) CPU_SET(cpu, &set);
+		int r = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+		if (r != 0) {
+			SafePrint::printf("[ThreadConfig::apply()] : [ERROR] : %s : CPU affinity could not be set: %s\n\r", name, strerror(r));
+			ok = false;
+		}
+	}
+	if (priority > 0) {
+		sched_param param = {};
+		param.sched_priority = priority;
+		int r = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+		if (r != 0) {
+			SafePrint::printf("[ThreadConfig::apply()] : [ERROR] : %s : SCHED_FIFO %d could not be set: %s%s\n\r", name, priority, strerror(r),
+					  r == EPERM ? " (needs CAP_SYS_NICE or an rtprio limit)" : "");
+			ok = false;
+		}
+	}
+	if (prefaultStack > 0) {
+		size_t bytes = prefaultStack < MAX_PREFAULT_STACK ? prefaultStack : MAX_PREFAULT_STACK;
+		size_t available = freeStack();
+		if (bytes > available) bytes = available;
+		if (bytes < prefaultStack) {
+			SafePrint::printf("[ThreadConfig::apply()] : [ERROR] : %s : only %zu of %zu KiB stack prefaulted (at most %zu KiB and the free stack)\n\r",
+					  name, bytes / 1024, prefaultStack / 1024, MAX_PREFAULT_STACK / 1024);
+			ok = false;
+		}
+		prefault(bytes);
+	}
+	if (!isDefault()) {
+		SafePrint::printf("[ThreadConfig::apply()] : %s : %s\n\r", name, describe().c_str());
+	}
+	return ok;
+}
+
+bool ThreadConfig::parseCpus(const std::string& list) {
+	std::vector<int> parsed;
+	const char* p = list.c_str();
+	while (*p) {
+		char* end;
+		long first = strtol(p, &end, 10);
+		if (end == p || first < 0 || first >= CPU_SETSIZE) return false;
+		long last = first;
+		p = end;
+		if (*p == '-') {
+			p++;
+			last = strtol(p, &end, 10);
+			if (end == p || last < first || last >= CPU_SETSIZE) return false;
+			p = end;
+		}
+		for (long cpu = first; cpu <= last; cpu++) parsed.push_back(cpu);
+		if (*p == ',') p++;
+		else if (*p != '\0') return false;
+	}
+	if (parsed.empty()) return false;
+	cpus = parsed;
+	return true;
+}
+
+std::string ThreadConfig::describe() const {
+	std::string s = priority > 0 ? "SCHED_FIFO " + std::to_string(priority) : "SCHED_OTHER";
+	if (!cpus.empty()) {
+		s += ", CPUs ";
+		for (size_t i = 0; i < cpus.size(); i++) {
+			if (i > 0) s += ",";
+			s += std::to_string(cpus[i]);
+		}
+	}
+	if (prefaultStack > 0) s += ", " + std::to_string(prefaultStack / 1024) + " KiB stack prefaulted";
+	return s;
+}
+
+bool ThreadConfig::lockMemory() {
+	// freed memory stays in the process, a later malloc() must not fault in fresh pages
+	mallopt(M_TRIM_THRESHOLD, -1);
+	mallopt(M_MMAP_MAX, 0);
+	if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0) {
+		SafePrint::printf("[ThreadConfig::lockMemory()] : [ERROR] : memory could not be locked: %s%s\n\r", strerror(errno),
+				  errno == EPERM || errno == ENOMEM ? " (needs CAP_IPC_LOCK or a larger memlock limit)" : "");
+		return false;
+	}
+	SafePrint::printf("[ThreadConfig::lockMemory()] : process memory locked\n\r");
+	return true;
+}
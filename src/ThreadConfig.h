@@ -0,0 +1,60 @@
+#ifndef THREAD_CONFIG_H
+#define THREAD_CONFIG_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+/**
+ * Real-time settings of one of the acquisition threads (GPIOReactor, GPIO callback executors,
+ * I2C bus threads, sensor processing threads). A thread applies its configuration itself when
+ * it starts, so that stack prefaulting happens on the stack that is used later.
+ *
+ * SCHED_FIFO needs CAP_SYS_NICE or an RLIMIT_RTPRIO (e.g. "@gpio - rtprio 90" in
+ * /etc/security/limits.conf); without it the thread keeps the normal scheduling and an error
+ * is printed. The default configuration changes nothing.
+ */
+struct ThreadConfig {
+    int priority = 0;          // SCHED_FIFO priority 1 - 99, 0 = normal scheduling (SCHED_OTHER)
+    std::vector<int> cpus;     // CPUs the thread may run on, empty = any
+    size_t prefaultStack = 0;  // bytes of stack touched up front, so the first event takes no page faults
+
+    // most stack prefaulted, well below the 8 MiB default stack; apply() also limits it to the free stack
+    static constexpr size_t MAX_PREFAULT_STACK = 4 * 1024 * 1024;
+
+    bool isDefault() const { return priority == 0 && cpus.empty() && prefaultStack == 0; }
+
+    /**
+     * Applies the configuration to the calling thread and names it (shown by "ps -L", "top -H").
+     * \param name Thread name, at most 15 characters are kept.
+     * \return false if a setting could not be applied, the others are applied nevertheless.
+     **/
+    bool apply(const char* name) const;
+
+    /**
+     * Parses a CPU list such as "3" or "2,3" or "0-1,3" into cpus.
+     * \return false on a syntax error.
+     **/
+    bool parseCpus(const std::string& list);
+
+    // e.g. "SCHED_FIFO 80, CPUs 2,3, 64 KiB stack prefaulted"
+    std::string describe() const;
+
+    /**
+     * Locks all current and future pages of the process into RAM (mlockall) and stops malloc
+     * from returning memory to the kernel, so that no acquisition thread waits for a page
+     * fault once it runs. Process-wide, needs CAP_IPC_LOCK or a large enough RLIMIT_MEMLOCK.
+     * \return false if the memory could not be locked.
+     **/
+    static bool lockMemory();
+};
+
+#endif // THREAD_CONFIG_H
@@ -0,0 +1,75 @@
+#include "TimestampService.h"
+#include <cstdio>
+
+#define OFFSET_SAMPLES 3
+
+TimestampService& TimestampService::get() {
+	static TimestampService service;
+	return service;
+}
+
+TimestampService::TimestampService() {
+	refresh();
+}
+
+int64_t TimestampService::monotonicNow() {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return toNs(ts);
+}
+
+/**
+ * Measures CLOCK_REALTIME - CLOCK_MONOTONIC. The monotonic clock is read on both sides of
+ * the realtime read and the sample with the narrowest bracket is kept, so a preemption
+ * between the two clock reads does not end up in the offset.
+ */
+void TimestampService::refresh() {
+	int64_t best_offset = 0;
+	int64_t best_width = INT64_MAX;
+	int64_t mono_after = 0;
+	for (int i = 0; i < OFFSET_SAMPLES; i++) {
+		timespec before, wall, after;
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		clock_gettime(CLOCK_REALTIME, &wall);
+		clock_gettime(CLOCK_MONOTONIC, &after);
+		int64_t width = toNs(after) - toNs(before);
+		if (width < best_width) {
+			best_width = width;
+			best_offset = toNs(wall) - (toNs(before) + width / 2);
+		}
+		mono_after = toNs(after);
+	}
+	offsetNs.store(best_offset, std::memory_order_relaxed);
+	refreshedAtNs.store(mono_after, std::memory_order_relaxed);
+}
+
+int64_t TimestampService::offset(int64_t monoNs) {
+	// concurrent refreshes are harmless: each one stores a valid measurement
+	if (monoNs - refreshedAtNs.load(std::memory_order_relaxed) > REFRESH_INTERVAL_NS) {
+		refresh();
+	}
+	return offsetNs.load(std::memory_order_relaxed);
+}
+
+int64_t TimestampService::fromMonotonic(const timespec& ts) {
+	return toNs(ts) + offset(monotonicNow());
+}
+
+int64_t TimestampService::fromEvent(const gpiod_line_event& e) {
+	return fromMonotonic(e.ts);
+}
+
+int64_t TimestampService::now() {
+	int64_t mono = monotonicNow();
+	return mono + offset(mono);
+}
+
+const char* TimestampService::format(int64_t wallNs, char* buf, size_t len) {
+	time_t secs = wallNs / NS_PER_SEC;
+	long usecs = (wallNs % NS_PER_SEC) / 1000;
+	struct tm tm;
+	localtime_r(&secs, &tm);
+	size_t n = strftime(buf, len, "%Y-%m-%d %H:%M:%S", &tm);
+	snprintf(buf + n, len - n, ".%06ld", usecs);
+	return buf;
+}
@@ -0,0 +1,69 @@
+#ifndef TIMESTAMP_SERVICE_H
+#define TIMESTAMP_SERVICE_H
+
+/*
+ * Copyright (c) 2025 Pragya Shilakari, Gregory Paphiti, Abhishek Jain, Ninad Shende, Ugochukwu Elvis Som Anene, Hankun Ma
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation. See the file LICENSE.
+ */
+
+#include "GPIODCompat.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <atomic>
+
+/**
+ * TimestampService provides process-wide wall clock timestamps in integer nanoseconds
+ * since the Unix epoch for the publisher, the GUI and the logs.
+ *
+ * GPIO events already carry a kernel timestamp taken in the interrupt (gpiod_line_event::ts,
+ * CLOCK_MONOTONIC). It is converted to wall time by adding the offset between
+ * CLOCK_REALTIME and CLOCK_MONOTONIC. The offset is re-measured at most every
+ * REFRESH_INTERVAL_NS, so clock corrections made by the system time daemon
+ * (systemd-timesyncd / chrony) are followed without any network access on the data path.
+ */
+class TimestampService {
+
+public:
+    static constexpr int64_t NS_PER_SEC = 1000000000LL;
+    static constexpr int64_t REFRESH_INTERVAL_NS = 1 * NS_PER_SEC;
+
+    // buffer size needed by format(): "YYYY-MM-DD hh:mm:ss.uuuuuu"
+    static constexpr size_t FORMAT_SIZE = 32;
+
+    static TimestampService& get();
+
+    /**
+     * Wall clock time of a GPIO event, stamped by the kernel on CLOCK_MONOTONIC.
+     **/
+    int64_t fromEvent(const gpiod_line_event& e);
+
+    // Wall clock time of a CLOCK_MONOTONIC timestamp.
+    int64_t fromMonotonic(const timespec& ts);
+
+    // Current wall clock time.
+    int64_t now();
+
+    /**
+     * Formats a wall clock timestamp as local time with microseconds into buf.
+     * \return buf, so it can be used directly as printf argument.
+     **/
+    static const char* format(int64_t wallNs, char* buf, size_t len);
+
+    static int64_t toNs(const timespec& ts) { return ts.tv_sec * NS_PER_SEC + ts.tv_nsec; }
+    static int64_t monotonicNow();
+
+private:
+    TimestampService();
+
+    std::atomic<int64_t> offsetNs{0};        // CLOCK_REALTIME - CLOCK_MONOTONIC
+    std::atomic<int64_t> refreshedAtNs{0};   // CLOCK_MONOTONIC time of the last measurement
+
+    int64_t offset(int64_t monoNs);
+    void refresh();
+};
+
+#endif // TIMESTAMP_SERVICE_H
@@ -1,11 +1,14 @@
 #include "buzzer.h"
 #include "SafePrint.h"
+#include "BinaryLog.h"
+#include <string>
 
 // Mutex to protect the shared buzzer resoure from race conditions in a multi-threaded environment
 std::mutex Buzzer::buzzer_mtx;
 
 //Constructor definition
 Buzzer::Buzzer(int chip_num, int line_num) {
+#ifndef GPIOD_V2
     chip = gpiod_chip_open_by_number(chip_num);
     if (!chip) {
         SafePrint::printf("[Buzzer] :: Error : Failed to open GPIO chip {%d} for Buzzer\n\r", chip_num);
@@ -26,26 +29,195 @@ Buzzer::Buzzer(int chip_num, int line_num) {
         chip = nullptr;
         line = nullptr;
     }
+#else
+    std::string path = "/dev/gpiochip" + std::to_string(chip_num);
+    chip = gpiod_chip_open(path.c_str());
+    if (!chip) {
+        SafePrint::printf("[Buzzer] :: Error : Failed to open GPIO chip {%d} for Buzzer\n\r", chip_num);
+        return;
+    }
+
+    offset = line_num;
+    gpiod_line_settings* settings = gpiod_line_settings_new();
+    gpiod_line_config* lineConfig = gpiod_line_config_new();
+    gpiod_request_config* requestConfig = gpiod_request_config_new();
+    if (settings && lineConfig && requestConfig) {
+        gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_OUTPUT);
+        gpiod_line_settings_set_output_value(settings, GPIOD_LINE_VALUE_INACTIVE);
+        gpiod_request_config_set_consumer(requestConfig, "buzzer");
+        if (gpiod_line_config_add_line_settings(lineConfig, &offset, 1, settings) == 0) {
+            line = gpiod_chip_request_lines(chip, requestConfig, lineConfig);
+        }
+    }
+    if (requestConfig) gpiod_request_config_free(requestConfig);
+    if (lineConfig) gpiod_line_config_free(lineConfig);
+    if (settings) gpiod_line_settings_free(settings);
+    if (!line) {
+        SafePrint::printf("[Buzzer] :: Error : Failed to request buzzer line {%d} as output\n\r", line_num);
+        gpiod_chip_close(chip);
+        chip = nullptr;
+    }
+#endif
 }
 
 //Destructor definition
 Buzzer::~Buzzer() {
+    {
+        std::lock_guard<std::mutex> lock(beep_mtx);
+        running = false;
+    }
+    beep_cv.notify_one();
+    if (thr.joinable()) thr.join();
+    if (beeping) off();
+#ifndef GPIOD_V2
     if (line) gpiod_line_release(line);
+#else
+    if (line) gpiod_line_request_release(line);
+#endif
     if (chip) gpiod_chip_close(chip);
 }
 
 void Buzzer::on() {
     std::lock_guard<std::mutex> lock(buzzer_mtx); //acquire the lock to perform the buzzer operation
     if (line) {
-        SafePrint::printf("[Buzzer] :: Beep the buzzer\n\r");
+        SAFE_PRINTF("[Buzzer] :: Beep the buzzer\n\r");
+#ifndef GPIOD_V2
         gpiod_line_set_value(line, 1);
+#else
+        gpiod_line_request_set_value(line, offset, GPIOD_LINE_VALUE_ACTIVE);
+#endif
     }
 } //lock released on exit
 
 void Buzzer::off() {
     std::lock_guard<std::mutex> lock(buzzer_mtx); //acquire the lock to perform the buzzer operation
     if (line) {
-        SafePrint::printf("[Buzzer] :: Turn-Off the beep\n\r");
+        SAFE_PRINTF("[Buzzer] :: Turn-Off the beep\n\r");
+#ifndef GPIOD_V2
         gpiod_line_set_value(line, 0);
+#else
+        gpiod_line_request_set_value(line, offset, GPIOD_LINE_VALUE_INACTIVE);
+#endif
+    }
+} //lock released on exit
+
+Buzzer::Pattern Buzzer::Pattern::beep(std::chrono::milliseconds duration, int priority) {
+    Pattern p;
+    p.onTime = duration;
+    p.offTime = std::chrono::milliseconds(0);
+    p.priority = priority;
+    return p;
+}
+
+bool Buzzer::Pattern::sameSound(const Pattern& other) const {
+    return beeps == other.beeps && onTime == other.onTime && offTime == other.offTime &&
+           repeat == other.repeat && pause == other.pause;
+}
+
+void Buzzer::play(const Pattern& pattern) {
+    if (pattern.beeps == 0 || pattern.onTime.count() <= 0) return;
+    std::lock_guard<std::mutex> lock(beep_mtx);
+    auto it = patterns.find(pattern.priority);
+    if (it != patterns.end() && it->second.pattern.sameSound(pattern)) {
+        // duplicate request: keeps sounding, all repetitions again from the current one
+        it->second.repetition = 0;
+    } else {
+        Playback p;
+        p.pattern = pattern;
+        if (it != patterns.end() && playing == &it->second) playing = nullptr;
+        patterns[pattern.priority] = p;
+    }
+    if (!running) {
+        // started on first use, most runs never raise an alarm
+        running = true;
+        thr = std::thread(&Buzzer::worker, this);
     }
-} //lock released on exit
\ No newline at end of file
+    beep_cv.notify_one();
+}
+
+void Buzzer::cancel(int priority) {
+    std::lock_guard<std::mutex> lock(beep_mtx);
+    auto it = patterns.find(priority);
+    if (it == patterns.end()) return;
+    if (playing == &it->second) playing = nullptr;
+    patterns.erase(it);
+    beep_cv.notify_one();
+}
+
+void Buzzer::cancelAll() {
+    std::lock_guard<std::mutex> lock(beep_mtx);
+    patterns.clear();
+    playing = nullptr;
+    beep_cv.notify_one();
+}
+
+void Buzzer::beep(std::chrono::milliseconds duration) {
+    play(Pattern::beep(duration));
+}
+
+// called with beep_mtx held when p.next has passed
+void Buzzer::advance(Playback& p, Clock::time_point now) {
+    const Pattern& pattern = p.pattern;
+    if (!p.sounding) {
+        p.sounding = true;
+        p.next = now + pattern.onTime;
+        return;
+    }
+    p.sounding = false;
+    p.next = now + pattern.offTime;
+    if (++p.beep < pattern.beeps) return;
+    p.beep = 0;
+    p.repetition++;
+    p.next += pattern.pause;
+}
+
+void Buzzer::worker() {
+    std::unique_lock<std::mutex> lock(beep_mtx);
+    while (running) {
+        Clock::time_point now = Clock::now();
+        Playback* top = patterns.empty() ? nullptr : &patterns.rbegin()->second;
+        if (top != playing) {
+            // interrupted, cancelled or replaced: the interrupted pattern starts over later
+            if (playing) {
+                playing->started = false;
+                playing->sounding = false;
+                playing->beep = 0;
+            }
+            playing = top;
+        }
+        if (!top) {
+            if (beeping) {
+                off();
+                beeping = false;
+            }
+            beep_cv.wait(lock);
+            continue;
+        }
+        if (!top->started) {
+            top->started = true;
+            top->next = now;
+        }
+        if (now < top->next) {
+            Clock::time_point next = top->next; // top may be cancelled while we wait
+            beep_cv.wait_until(lock, next);
+            continue;
+        }
+        advance(*top, now);
+        const Pattern& pattern = top->pattern;
+        if (!top->sounding && pattern.repeat > 0 && top->repetition >= pattern.repeat) {
+            // done, the next lower pattern resumes at once
+            patterns.erase(pattern.priority);
+            playing = nullptr;
+            if (beeping) {
+                off();
+                beeping = false;
+            }
+            continue;
+        }
+        if (top->sounding != beeping) {
+            if (top->sounding) on();
+            else off();
+            beeping = top->sounding;
+        }
+    }
+}
@@ -18,22 +18,93 @@
  * limitations under the License.
  */
 
-#include <gpiod.h>
+#include "GPIODCompat.h"
+#include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <map>
 #include <mutex>
+#include <thread>
 
+/**
+ * Buzzer on an output line. Alarms are played as patterns by the buzzer thread, so that
+ * callers never wait for the sound: play() returns at once.
+ *
+ * Each priority holds one pattern. The highest priority pattern sounds; a higher priority
+ * pattern interrupts a lower one, which resumes with the first beep of its interrupted
+ * repetition when the higher one has finished or is cancelled. A pattern requested while the
+ * same pattern is pending at that priority is merged with it: it is not restarted, its
+ * repetitions are counted again from the one in progress.
+ */
 class Buzzer {
 public:
+    struct Pattern {
+	unsigned beeps = 1;                      // beeps per repetition
+	std::chrono::milliseconds onTime{200};   // length of each beep
+	std::chrono::milliseconds offTime{200};  // silence after each beep
+	unsigned repeat = 1;                     // repetitions, 0 = until cancelled
+	std::chrono::milliseconds pause{0};      // extra silence between repetitions
+	int priority = 0;                        // higher interrupts lower
+
+	// a single beep of duration
+	static Pattern beep(std::chrono::milliseconds duration, int priority = 0);
+	bool sameSound(const Pattern& other) const;
+    };
+
     Buzzer(int chip_num, int line_num);
     ~Buzzer();
 
     void on();
     void off();
 
+    /**
+     * Plays pattern at its priority without blocking the caller, replacing a different
+     * pattern of the same priority.
+     **/
+    void play(const Pattern& pattern);
+
+    // Stops the pattern of this priority, e.g. when its alarm has been cleared.
+    void cancel(int priority);
+
+    // Stops all patterns.
+    void cancelAll();
+
+    // Sounds the buzzer for duration, play(Pattern::beep(duration)).
+    void beep(std::chrono::milliseconds duration);
+
 private:
     struct gpiod_chip* chip = nullptr;
+#ifndef GPIOD_V2
     struct gpiod_line* line = nullptr;
+#else
+    struct gpiod_line_request* line = nullptr;
+    unsigned int offset = 0;
+#endif
     static std::mutex buzzer_mtx;
+
+    using Clock = std::chrono::steady_clock;
+
+    // a requested pattern and how far it has been played
+    struct Playback {
+	Pattern pattern;
+	bool started = false;
+	bool sounding = false;
+	unsigned beep = 0;         // beep of the current repetition
+	unsigned repetition = 0;   // repetitions completed
+	Clock::time_point next;    // next change of the line
+    };
+
+    // patterns by priority, the last one sounds; served by the buzzer thread
+    std::mutex beep_mtx;
+    std::condition_variable beep_cv;
+    std::thread thr;
+    std::map<int, Playback> patterns;
+    Playback* playing = nullptr;
+    bool beeping = false;
+    bool running = false;
+
+    void worker();
+    void advance(Playback& p, Clock::time_point now);
 };
 
 #endif // BUZZER_H
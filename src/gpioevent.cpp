@@ -4,16 +4,134 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
+#include <sys/timerfd.h>
 #include <string>
 #include "SafePrint.h" //safe printf in multi-threaded environment
+#include "BinaryLog.h" //binary logging of the per-event messages
+#include "GPIOExecutor.h"
+#include "TimestampService.h"
+
+// defined here, where the GPIOCallbackExecutor is complete
+GPIOPin::GPIOPin() {
+}
+
+GPIOPin::~GPIOPin() {
+	stop();
+}
+
+void GPIOPin::registerCallback(GPIOEventCallbackInterface* ci) {
+	registerCallback(ci, CallbackOptions());
+}
+
+void GPIOPin::registerCallback(GPIOEventCallbackInterface* ci, const CallbackOptions& options) {
+	Callback c;
+	c.cb = ci;
+	if (options.executor != INLINE) {
+		c.executor.reset(new GPIOCallbackExecutor(ci, options, &dispatchLatency, &handledLatency));
+	}
+	callbackInterfaces.push_back(std::move(c));
+}
 
 void GPIOPin::start(int pinNo,
 		    int chipNo, std::string processName) {
 	
+    if (running) {
+#ifdef DEBUG
+	SafePrint::printf("[ERROR] GPIO pin %d on chip %d is already started.\n\r",pinNo,chipNo);
+#endif
+	return;
+    }
+
 #ifdef DEBUG
     SafePrint::printf("[ERROR] GPIO pin %d on chip %d is being init.\n\r",pinNo,chipNo);
 #endif
 
+    // a restarted pin starts from a clean line state
+#ifndef GPIOD_V2
+    lastEventType = 0;
+#else
+    lastSeqno = 0;
+#endif
+    filter.configure(filter.getOptions());
+    for (auto& cb : callbackInterfaces) {
+	if (cb.executor) cb.executor->start();
+    }
+
+    requestLine(pinNo, chipNo, processName);
+    events.resize(eventBufferSize);
+    // an edge released by the timer can precede a burst in which each edge completes a pulse
+    filtered.reserve(2 * eventBufferSize + 1);
+
+    /**
+     * A line that is already low (active) at startup has no edge pending, e.g. a TMP117 ALERT
+     * latched before the process started. It is passed on as a falling edge at the current time,
+     * through the filter and the burst policy like an edge read from the line; a filter that
+     * pairs pulses drops it as unpaired. Done before the reactor waits for the line, so the
+     * filter is not shared with the reactor thread yet. Not an edge of the line, so it is
+     * passed to all callbacks right here and kept out of the latency histograms.
+     */
+    filtered.clear();
+    if (readValue() == 0) {
+	SafePrint::printf("[GPIOPin::start()] : GPIO Pin low at startup — delivering a falling edge\n\r");
+	gpiod_line_event low;
+	low.event_type = GPIOD_LINE_EVENT_FALLING_EDGE;
+	int64_t now = TimestampService::monotonicNow();
+	low.ts.tv_sec = now / TimestampService::NS_PER_SEC;
+	low.ts.tv_nsec = now % TimestampService::NS_PER_SEC;
+	if (filter.enabled()) {
+	    filter.input(low, filtered);
+	} else {
+	    filtered.push_back(low);
+	}
+	deliver(filtered.data(), filtered.size(), false);
+    }
+
+    // the filter releases held edges with a timer on the kernel's clock of the edges
+    if (filter.needsTimer()) {
+	timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (timerFd < 0) {
+#ifdef DEBUG
+	    SafePrint::printf("[ERROR] Filter timer of pin %d on chip %d could not be created.\n\r",
+		    pinNo,chipNo);
+#endif
+	    releaseLine();
+	    throw "Could not create the filter timer.";
+	}
+	// a startup edge held back by the filter is released by the timer
+	armFilterTimer();
+    }
+
+	/**
+	 * The event file descriptor becomes readable when an event is pending, the GPIOReactor
+	 * waits for it together with the descriptors of all other pins.
+	 */
+    if (eventFd < 0 || !GPIOReactor::get().add(eventFd, this)) {
+#ifdef DEBUG
+	SafePrint::printf("[ERROR] Events of pin %d on chip %d can't be waited for.\n\r",
+		pinNo,chipNo);
+#endif
+	if (timerFd >= 0) close(timerFd);
+	timerFd = -1;
+	releaseLine();
+	throw "Could not wait for IRQ.";
+    }
+    if (timerFd >= 0 && !GPIOReactor::get().add(timerFd, this)) {
+#ifdef DEBUG
+	SafePrint::printf("[ERROR] Filter timer of pin %d on chip %d can't be waited for.\n\r",
+		pinNo,chipNo);
+#endif
+	close(timerFd);
+	timerFd = -1;
+	GPIOReactor::get().remove(eventFd);
+	releaseLine();
+	throw "Could not create the filter timer.";
+    }
+    running = true;
+}
+
+#ifndef GPIOD_V2
+
+void GPIOPin::requestLine(int pinNo, int chipNo, const std::string& processName) {
 	/**
 	 * @brief Open a gpiochip by number.
 	 * @param num Number of the gpiochip.
@@ -40,6 +158,7 @@ void GPIOPin::start(int pinNo,
 #ifdef DEBUG
 	SafePrint::printf("[ERROR] GPIO line could not be accessed.\n\r");
 #endif
+	gpiod_chip_close(chipGPIO);
 	throw "GPIO line error.\n\r";
     }
 
@@ -56,115 +175,302 @@ void GPIOPin::start(int pinNo,
 	SafePrint::printf("[ERROR] Request event notification failed on pin %d and chip %d.\n\r",
 		pinNo,chipNo);
 #endif
+	gpiod_chip_close(chipGPIO);
 	throw "Could not request event for IRQ.";
     }
 
-    running = true;
-	/*
-	* Concurrently execute non-static member function GPIOPin::worker()
-	* Pass fuction reference and object reference as params
-	*/
-    thr = std::thread(&GPIOPin::worker,this);
+#ifdef DEBUG
+    if (debounceUs > 0) {
+	SafePrint::printf("[GPIOPin::start()] : kernel debounce needs libgpiod v2, pin %d is not debounced.\n\r", pinNo);
+    }
+#endif
+    // the v1 character device queues at most 16 events per line
+    eventBufferSize = KERNEL_EVENT_FIFO_SIZE;
+
+	/**
+	 * @brief Get the file descriptor associated with a line event.
+	 * @param line GPIO line object.
+	 * @return Number of the file descriptor associated with the line event, -1 on error.
+	 */
+    eventFd = gpiod_line_event_get_fd(pinGPIO);
+}
+
+int GPIOPin::readValue() {
+	/**
+	 * @brief Read current value of a single GPIO line.
+	 * @param line GPIO line object.
+	 * @return 0 or 1 if the operation succeeds. On error this routine returns -1
+	 *         and sets the last error number.
+	 */
+	return gpiod_line_get_value(pinGPIO);
+}
+
+int GPIOPin::readEvents() {
+	/**
+	 * @brief Read up to a certain number of events from the GPIO line.
+	 * @param line GPIO line object.
+	 * @param events Buffer to which the event data will be copied. Must hold at
+	 *               least the amount of events specified in num_events.
+	 * @param num_events Specifies how many events can be stored in the buffer.
+	 * @return On success returns the number of events stored in the buffer, on
+	 *         failure -1 is returned.
+	 * Drains the whole burst with a single read() instead of one syscall per edge.
+	 */
+	int n = gpiod_line_event_read_multiple(pinGPIO, events.data(), events.size());
+	for (int i = 0; i < n; i++) {
+	    // both edges are requested, so they must alternate
+	    if (events[i].event_type == lastEventType) nLostEdges++;
+	    lastEventType = events[i].event_type;
+	}
+	return n;
+}
+
+void GPIOPin::releaseLine() {
+	/**
+	 * @brief Release a previously reserved line.
+	 * @param line GPIO line object.
+	 */
+    gpiod_line_release(pinGPIO);
+
+	/**
+	 * @brief Close a GPIO chip handle and release all allocated resources.
+	 * @param chip The GPIO chip object.
+	 */
+    gpiod_chip_close(chipGPIO);
+    pinGPIO = nullptr;
+    chipGPIO = nullptr;
+}
+
+gpiod_line* GPIOPin::getLine() {
+	return pinGPIO;
+}
+
+#else // GPIOD_V2
+
+void GPIOPin::requestLine(int pinNo, int chipNo, const std::string& processName) {
+    std::string path = "/dev/gpiochip" + std::to_string(chipNo);
+    chipGPIO = gpiod_chip_open(path.c_str());
+    if (NULL == chipGPIO) {
+#ifdef DEBUG
+	SafePrint::printf("[ERROR] GPIO chip could not be accessed.\n\r");
+#endif
+	throw "GPIO chip error.\n\r";
+    }
+
+	/**
+	 * Both edges, debounced by the kernel if requested, and stamped with CLOCK_MONOTONIC
+	 * like the v1 events so that TimestampService::fromEvent() applies unchanged.
+	 */
+    offset = pinNo;
+    gpiod_line_settings* settings = gpiod_line_settings_new();
+    gpiod_line_config* lineConfig = gpiod_line_config_new();
+    gpiod_request_config* requestConfig = gpiod_request_config_new();
+    if (settings && lineConfig && requestConfig) {
+	gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
+	gpiod_line_settings_set_edge_detection(settings, GPIOD_LINE_EDGE_BOTH);
+	gpiod_line_settings_set_event_clock(settings, GPIOD_LINE_CLOCK_MONOTONIC);
+	gpiod_line_settings_set_debounce_period_us(settings, debounceUs);
+	if (gpiod_line_config_add_line_settings(lineConfig, &offset, 1, settings) == 0) {
+	    gpiod_request_config_set_consumer(requestConfig, processName.c_str());
+	    // the kernel queues as many edges as are read in one go
+	    gpiod_request_config_set_event_buffer_size(requestConfig, eventBufferSize);
+	    request = gpiod_chip_request_lines(chipGPIO, requestConfig, lineConfig);
+	}
+    }
+    if (requestConfig) gpiod_request_config_free(requestConfig);
+    if (lineConfig) gpiod_line_config_free(lineConfig);
+    if (settings) gpiod_line_settings_free(settings);
+    if (NULL == request) {
+#ifdef DEBUG
+	SafePrint::printf("[ERROR] Request event notification failed on pin %d and chip %d.\n\r",
+		pinNo,chipNo);
+#endif
+	gpiod_chip_close(chipGPIO);
+	throw "Could not request event for IRQ.";
+    }
+
+    edgeEvents = gpiod_edge_event_buffer_new(eventBufferSize);
+    if (NULL == edgeEvents) {
+	gpiod_line_request_release(request);
+	gpiod_chip_close(chipGPIO);
+	throw "Could not allocate the edge event buffer.";
+    }
+    eventFd = gpiod_line_request_get_fd(request);
+}
+
+int GPIOPin::readValue() {
+	gpiod_line_value value = gpiod_line_request_get_value(request, offset);
+	if (value == GPIOD_LINE_VALUE_ERROR) return -1;
+	return value == GPIOD_LINE_VALUE_ACTIVE ? 1 : 0;
+}
+
+int GPIOPin::readEvents() {
+	// drains the whole burst with a single read() instead of one syscall per edge
+	int n = gpiod_line_request_read_edge_events(request, edgeEvents, events.size());
+	for (int i = 0; i < n; i++) {
+	    gpiod_edge_event* e = gpiod_edge_event_buffer_get_event(edgeEvents, i);
+	    uint64_t ns = gpiod_edge_event_get_timestamp_ns(e);
+	    events[i].ts.tv_sec = ns / 1000000000ULL;
+	    events[i].ts.tv_nsec = ns % 1000000000ULL;
+	    events[i].event_type = gpiod_edge_event_get_event_type(e);
+	    // the kernel numbers the edges of a line, a gap is the number of edges it dropped
+	    unsigned long seqno = gpiod_edge_event_get_line_seqno(e);
+	    if (lastSeqno != 0 && seqno > lastSeqno + 1) nLostEdges += seqno - lastSeqno - 1;
+	    lastSeqno = seqno;
+	}
+	return n;
+}
+
+void GPIOPin::releaseLine() {
+    gpiod_edge_event_buffer_free(edgeEvents);
+    gpiod_line_request_release(request);
+    gpiod_chip_close(chipGPIO);
+    edgeEvents = nullptr;
+    request = nullptr;
+    chipGPIO = nullptr;
 }
 
-void GPIOPin::gpioEvent(gpiod_line_event& event) {
+gpiod_line_request* GPIOPin::getRequest() {
+	return request;
+}
+
+#endif // GPIOD_V2
+
+void GPIOPin::gpioEvent(gpiod_line_event* events, int n, bool measured) {
 	/*
 	* Loops over each element in the callbackInterfaces vector 
 	* Using element reference and not copying element
 	* Deduces the element type automatically
 	*/
 	for(auto &cb: callbackInterfaces) {
-		SafePrint::printf("[GPIOPin::gpioEvent()] : GPIO event received...\n\r");
-	    cb->hasEvent(event);
-		//DEBUG
-		usleep(1000);
-		int level = gpiod_line_get_value(pinGPIO);
-		SafePrint::printf("[GPIOPin::gpioEvent()] : [DEBUG] : GPIO pin state after read: %d\n\r", level);
+		SAFE_PRINTF("[GPIOPin::gpioEvent()] : GPIO event received...\n\r");
+	    if (!measured) {
+		// before the line is watched, nothing else is queued for the callback yet
+		GPIOCallbackExecutor::invoke(cb.cb, events, n, nullptr, nullptr);
+	    } else if (cb.executor) {
+		// queued, a slow callback doesn't hold up the line or the other callbacks
+		cb.executor->post(events, n);
+	    } else {
+		GPIOCallbackExecutor::invoke(cb.cb, events, n, &dispatchLatency, &handledLatency);
+	    }
 	}
 }
 
 
-void GPIOPin::worker() {
+void GPIOPin::onReadable(int fd) {
+	if (fd == timerFd) {
+	    uint64_t expirations;
+	    if (read(timerFd, &expirations, sizeof(expirations)) < 0) return; // already handled
+	    filtered.clear();
+	    filter.expire(TimestampService::monotonicNow(), filtered);
+	    armFilterTimer();
+	    deliver(filtered.data(), filtered.size());
+	    return;
+	}
 
-	int value = gpiod_line_get_value(pinGPIO);
-	if (value == 0) {
-		SafePrint::printf("[GPIOPin::worker()] : GPIO Pin low at startup — force read to clear ALERT\n\r");
-		gpiod_line_event fake_event;
-        fake_event.event_type = GPIOD_LINE_EVENT_FALLING_EDGE;
+	int n = readEvents();
+	if (n <= 0) {
+#ifdef DEBUG
+	    SafePrint::printf("[ERROR] GPIO error while reading event.\n\r");
+#endif
+	    return;
+	}
 
-        // Set dummy timestamp (optional)
-        fake_event.ts.tv_sec = 0;
-        fake_event.ts.tv_nsec = 0;
+	nEvents += n;
+	nBursts++;
+	if ((uint64_t)n > nMaxBurst) nMaxBurst = n; // written by the reactor thread only
+	if ((size_t)n == events.size()) nFullReads++;
 
-        gpioEvent(fake_event);  
+	if (filter.enabled()) {
+	    filtered.clear();
+	    for (int i = 0; i < n; i++) filter.input(events[i], filtered);
+	    if (timerFd >= 0) armFilterTimer();
+	    deliver(filtered.data(), filtered.size());
+	    return;
 	}
-    while (running) {
-	const timespec ts = { ISR_TIMEOUT, 0 };
+	deliver(events.data(), n);
+}
 
-	/**
-	 * this blocks till an interrupt has happened!
-	 * @brief Wait for an event on a single line.
-	 * @param line GPIO line object.
-	 * @param timeout Wait time limit.
-	 * @return 0 if wait timed out, -1 if an error occurred, 1 if an event
-	 *         occurred.
-	 */
-	int r = gpiod_line_event_wait(pinGPIO, &ts);
-
-	// check if it really has been an event
-	if (1 == r) {
-	    gpiod_line_event event;
-
-		/**
-		 * @brief Read next pending event from the GPIO line.
-		 * @param line GPIO line object.
-		 * @param event Buffer to which the event data will be copied.
-		 * @return 0 if the event was read correctly, -1 on error.
-		 * @note This function will block if no event was queued for this line.
-		 */
-	    gpiod_line_event_read(pinGPIO, &event);
-
-		/**
-		 * @brief Read current value of a single GPIO line.
-		 * @param line GPIO line object.
-		 * @return 0 or 1 if the operation succeeds. On error this routine returns -1
-		 *         and sets the last error number.
-		 */
-		gpiod_line_get_value(pinGPIO);
-		
-		//call the event handler
-	    gpioEvent(event);
-	} else if (r < 0) {
-#ifdef DEBUG
-	    SafePrint::printf("[ERROR] GPIO error while waiting for event.\n\r");
+void GPIOPin::armFilterTimer() {
+	itimerspec its = {};
+	int64_t deadline = filter.deadline();
+	if (deadline > 0) {
+	    its.it_value.tv_sec = deadline / TimestampService::NS_PER_SEC;
+	    its.it_value.tv_nsec = deadline % TimestampService::NS_PER_SEC;
+	}
+	// absolute time on CLOCK_MONOTONIC, the clock of the kernel edge timestamps; 0 disarms
+	timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &its, nullptr);
+}
 
-#endif
+void GPIOPin::deliver(gpiod_line_event* events, int n, bool measured) {
+	if (n == 0) return;
+	// pairs of edges (whole pulses) are never coalesced
+	if (n > 1 && burstPolicy == COALESCE_LATEST && !filter.getOptions().pairPulses) {
+	    nCoalesced += n - 1;
+	    gpioEvent(&events[n - 1], 1, measured);
+	    return;
 	}
-    }
+
+	//call the event handler
+	gpioEvent(events, n, measured);
 }
 
 
 void GPIOPin::stop() {
     
-	if (!running) return;
+	// only one caller gets to release the line
+	if (!running.exchange(false)) return;
 	
-	// set running to false to signal the worker() function to exit the loop so Thread can finish processing
-    running = false;
-	thr.join(); //wait for concurrent thread to finish processing 
+	// returns once the reactor is no longer in gpioEvent() for this pin
+	GPIOReactor::get().remove(eventFd);
+    if (timerFd >= 0) {
+	GPIOReactor::get().remove(timerFd);
+	close(timerFd);
+	timerFd = -1;
+    }
+    releaseLine();
+    eventFd = -1;
+	// deliver what the SERIAL and POOL callbacks still have queued
+    for (auto& cb : callbackInterfaces) {
+	if (cb.executor) cb.executor->stop();
+    }
+}
 
-	/**
-	 * @brief Release a previously reserved line.
-	 * @param line GPIO line object.
-	 */
-    gpiod_line_release(pinGPIO);
+GPIOPin::Stats GPIOPin::getStats() {
+	Stats s;
+	s.events = nEvents;
+	s.bursts = nBursts;
+	s.maxBurst = nMaxBurst;
+	s.coalesced = nCoalesced;
+	s.fullReads = nFullReads;
+	s.lostEdges = nLostEdges;
+	s.filter = filter.getStats();
+	for (auto& cb : callbackInterfaces) {
+	    if (!cb.executor) continue;
+	    GPIOCallbackExecutor::Stats e = cb.executor->getStats();
+	    s.callbackDrops += e.dropped;
+	    s.callbackMerges += e.merged;
+	}
+	return s;
+}
 
-	/**
-	 * @brief Close a GPIO chip handle and release all allocated resources.
-	 * @param chip The GPIO chip object.
-	 */
-    gpiod_chip_close(chipGPIO);
+void GPIOPin::printLatency(const char* name) const {
+	std::string label = std::string("[GPIOPin {") + name + "}] : edge to callback start";
+	dispatchLatency.print(label.c_str());
+	label = std::string("[GPIOPin {") + name + "}] : edge to callback return";
+	handledLatency.print(label.c_str());
 }
 
-gpiod_line* GPIOPin::getLine() {
-	return pinGPIO;
+void GPIOPin::printStats(const char* name) {
+	Stats s = getStats();
+	SafePrint::printf("[GPIOPin {%s}] : edges %llu in %llu reads (max %llu at once), coalesced %llu, kernel queue full %llu, lost edges %llu, callback queue drops %llu merges %llu\n\r",
+			  name, (unsigned long long)s.events, (unsigned long long)s.bursts, (unsigned long long)s.maxBurst,
+			  (unsigned long long)s.coalesced, (unsigned long long)s.fullReads, (unsigned long long)s.lostEdges,
+			  (unsigned long long)s.callbackDrops, (unsigned long long)s.callbackMerges);
+	if (filter.enabled()) {
+		SafePrint::printf("[GPIOPin {%s}] : filtered glitches %llu, merged pulses %llu, duplicates %llu, unpaired %llu, rate limited %llu\n\r",
+				  name, (unsigned long long)s.filter.glitches, (unsigned long long)s.filter.merged,
+				  (unsigned long long)s.filter.duplicates, (unsigned long long)s.filter.unpaired,
+				  (unsigned long long)s.filter.rateLimited);
+	}
 }
@@ -15,45 +15,155 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
-#include <thread>
-#include <gpiod.h>
+#include "GPIODCompat.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <vector>
 #include <string>
+#include "GPIOReactor.h"
+#include "LatencyHistogram.h"
+#include "GPIOEdgeFilter.h"
 
 // enable debug messages and error messages to stderr
 #ifndef NDEBUG
 #define DEBUG
 #endif
 
-#define ISR_TIMEOUT 1 // sec
+class GPIOCallbackExecutor;
 
 /*GPIOPin class instance represent the GPIO Pin of a given chip and provide funtionality 
-  to implement blocking IO event handling for events on the GPIO pin */
-class GPIOPin {
+  to implement event handling for events on the GPIO pin. The events of all pins are
+  dispatched by the process-wide GPIOReactor thread. */
+class GPIOPin : private GPIOReactor::Handler {
 
 public:
     /**
      * Destructor which makes sure the data acquisition
      * stops on exit.
      **/
-    ~GPIOPin() {
-	stop();
-    }
+    ~GPIOPin();
+    GPIOPin();
+
+    GPIOPin(const GPIOPin&) = delete;
+    GPIOPin& operator=(const GPIOPin&) = delete;
 
     struct GPIOEventCallbackInterface {
 	    /**
 	     * Called when a new sample is available.
 	     * This needs to be implemented in a derived
 	     * class by the client. Defined as abstract.
+	     * Inline callbacks run on the GPIOReactor thread shared by all pins, so they must
+	     * not block; register callbacks that take time with a SERIAL or POOL executor.
 	     * \param e If falling or rising.
 	     **/
 	virtual void hasEvent(gpiod_line_event& e) = 0;
+
+	    /**
+	     * Called with all events read from the line in one go, oldest first.
+	     * Override to handle a burst at once, by default each event is passed to hasEvent().
+	     * \param events The events of the burst.
+	     * \param n Number of events, at least 1.
+	     **/
+	virtual void hasEvents(gpiod_line_event* events, int n) {
+	    for (int i = 0; i < n; i++) hasEvent(events[i]);
+	}
+    };
+
+    /**
+     * Where a callback runs (see GPIOExecutor.h):
+     * INLINE : on the GPIOReactor thread, for callbacks that only record the edge
+     * SERIAL : on a thread of its own
+     * POOL   : on the threads shared by all POOL callbacks of the process
+     * SERIAL and POOL callbacks get the edges in order, never concurrently with themselves.
+     **/
+    enum Executor { INLINE, SERIAL, POOL };
+
+    /**
+     * What happens to a new edge when the queue of a SERIAL or POOL callback is full.
+     * DROP_NEWEST : the new edge is dropped
+     * DROP_OLDEST : the oldest queued edge is dropped
+     * MERGE_LATEST : the new edge replaces the newest queued one, so the callback still
+     *                learns the latest line state
+     **/
+    enum OverflowPolicy { DROP_NEWEST, DROP_OLDEST, MERGE_LATEST };
+
+    struct CallbackOptions {
+	Executor executor = INLINE;
+	size_t queueSize = 64;           // edges queued for a SERIAL or POOL callback
+	OverflowPolicy overflow = DROP_NEWEST;
     };
 
-    void registerCallback(GPIOEventCallbackInterface* ci) {
-	callbackInterfaces.push_back(ci);
+    /**
+     * Adds a callback for the events of this pin, must be called before start().
+     **/
+    void registerCallback(GPIOEventCallbackInterface* ci);
+    void registerCallback(GPIOEventCallbackInterface* ci, const CallbackOptions& options);
+
+    /**
+     * What is delivered when several events are pending on the line.
+     * DELIVER_ALL : every edge, in order (default)
+     * COALESCE_LATEST : only the latest edge of the burst, for lines where
+     *                   just the current state matters (e.g. a chattering PIR)
+     **/
+    enum BurstPolicy { DELIVER_ALL, COALESCE_LATEST };
+    void setBurstPolicy(BurstPolicy policy) {
+	burstPolicy = policy;
+    }
+
+    /**
+     * Filters the edges of this line before they reach the callbacks (debounce, hold-off,
+     * pulse pairing, rate limit), see GPIOEdgeFilter.h. Must be called before start().
+     **/
+    void setFilter(const GPIOEdgeFilter::Options& options) {
+	filter.configure(options);
+    }
+
+    // the v1 kernel interface keeps up to 16 events per line, all of them are read in one go
+    static constexpr unsigned KERNEL_EVENT_FIFO_SIZE = 16;
+
+    /**
+     * Lets the kernel filter out pulses shorter than period, so that a bouncing contact or a
+     * chattering PIR doesn't wake the process at all. Needs libgpiod v2, must be called before
+     * start(). 0 (default) turns debouncing off.
+     **/
+    void setDebounce(std::chrono::microseconds period) {
+	debounceUs = period.count();
+    }
+
+    /**
+     * Number of edges the kernel queues for this line and the most read at once.
+     * libgpiod v2 only, the v1 interface has a fixed queue of KERNEL_EVENT_FIFO_SIZE.
+     * Must be called before start().
+     **/
+    void setEventBufferSize(unsigned size) {
+	eventBufferSize = size > 0 ? size : 1;
     }
 
+    struct Stats {
+	uint64_t events = 0;     // edges read from the kernel
+	uint64_t bursts = 0;     // reads, each delivering a burst of edges
+	uint64_t maxBurst = 0;   // most edges read at once
+	uint64_t coalesced = 0;  // edges not delivered because of COALESCE_LATEST
+	uint64_t fullReads = 0;  // reads that found the kernel queue full, newer edges may be lost
+	uint64_t lostEdges = 0;  // edges dropped by the kernel (v2: sequence number gaps,
+	                         // v1: two edges of the same direction in a row)
+	uint64_t callbackDrops = 0;  // edges a SERIAL or POOL callback's full queue dropped
+	uint64_t callbackMerges = 0; // edges merged into a full queue (MERGE_LATEST)
+	GPIOEdgeFilter::Stats filter;
+    };
+    Stats getStats();
+    void printStats(const char* name);
+
+    /**
+     * Latency from the kernel timestamp of each edge to the moment a callback starts
+     * (dispatch) and returns (handled), over all callbacks of this line. Can be read
+     * at any time while the pin is running.
+     **/
+    const LatencyHistogram& getDispatchLatency() const { return dispatchLatency; }
+    const LatencyHistogram& getHandledLatency() const { return handledLatency; }
+    void printLatency(const char* name) const;
+
     /**
      * Starts listening on the GPIO pin.
      * \param chipNo GPIO Chip number. It's usually 0.
@@ -64,33 +174,68 @@ public:
 	       int ChipNo = 0, std::string processName = "Consumer");
 
     /**
-     * Stops listening to the pin.
+     * Stops listening to the pin. Returns as soon as the GPIOReactor is no longer in a callback
+     * of this pin and the SERIAL/POOL callbacks have handled their queued edges; nothing waits
+     * for a timeout, so the pin can be started again right away.
      **/
     void stop();
 
+#ifndef GPIOD_V2
     gpiod_line* getLine();
+#else
+    gpiod_line_request* getRequest();
+#endif
 
 private:
 
     // gpiod  related stuff
     gpiod_chip *chipGPIO = nullptr; //GPIO chip handle
+#ifndef GPIOD_V2
     gpiod_line *pinGPIO = nullptr; //handle to the GPIO line(pin)
+    int lastEventType = 0; // of the previous edge, 0 = none yet
+#else
+    gpiod_line_request *request = nullptr; //handle to the requested line
+    gpiod_edge_event_buffer *edgeEvents = nullptr; //edges read from the request
+    unsigned int offset = 0;
+    unsigned long lastSeqno = 0; // line sequence number of the previous edge
+#endif
+    int eventFd = -1; // becomes readable when events are pending
+    unsigned long debounceUs = 0;
+    unsigned eventBufferSize = KERNEL_EVENT_FIFO_SIZE;
+    std::vector<gpiod_line_event> events; // burst read by readEvents()
+    GPIOEdgeFilter filter;
+    std::vector<gpiod_line_event> filtered; // edges passed by the filter
+    int timerFd = -1; // releases the edges held by the filter
     
-    //pollfd pfd; 
+    // flag that it's running, stop() may be called from another thread than start()
+    std::atomic<bool> running{false};
 
-    // thread reference for concurrent execution
-    std::thread thr; 
-    
-    // flag that it's running
-    bool running = false;
+    std::atomic<BurstPolicy> burstPolicy{DELIVER_ALL};
+    LatencyHistogram dispatchLatency, handledLatency;
+    std::atomic<uint64_t> nEvents{0}, nBursts{0}, nMaxBurst{0}, nCoalesced{0}, nFullReads{0}, nLostEdges{0};
     
     // vector to hold the instances of GPIO event callback interfaces
-    std::vector<GPIOEventCallbackInterface*> callbackInterfaces;
+    // with their executor (null for INLINE callbacks)
+    struct Callback {
+	GPIOEventCallbackInterface* cb;
+	std::unique_ptr<GPIOCallbackExecutor> executor;
+    };
+    std::vector<Callback> callbackInterfaces;
     
-    //this fucntion call the event handler(s)
-    void gpioEvent(gpiod_line_event& event);
+    //this fucntion call the event handler(s), measured edges are recorded in the latency histograms
+    void gpioEvent(gpiod_line_event* events, int n, bool measured = true);
     
-    void worker();
+    // backend specific (libgpiod v1 or v2) part of start(), stop() and onReadable()
+    void requestLine(int pinNo, int chipNo, const std::string& processName);
+    void releaseLine();
+    int readValue();
+    int readEvents();
+
+    // reads all pending events or handles the filter timer, called by the GPIOReactor
+    void onReadable(int fd) override;
+    void armFilterTimer();
+    // applies the burst policy and calls the event handler(s)
+    void deliver(gpiod_line_event* events, int n, bool measured = true);
     
 
 };
@@ -1,7 +1,10 @@
 #include "window.h"
 #include "TMP117TemperatureSensor.h"
+#include "AlarmManager.h"
 
 Window::Window()
+    : lowThreshold(TMP117TemperatureSensor::LOW_THRESHOLD)
+    , highThreshold(TMP117TemperatureSensor::HIGH_THRESHOLD)
 {    
     // set up the thermometer
     thermo = new QwtThermo; 
@@ -63,12 +66,27 @@ Window::Window()
     // see https://doc.qt.io/qt-5/signalsandslots-syntaxes.html
     connect(button,&QPushButton::clicked,[this](){reset();});
 
+    // alarm state from the alarm manager, the button silences it and clears a latched alarm
+    alarmLabel = new QLabel;
+    alarmLabel->setAlignment(Qt::AlignCenter);
+    alarmLabel->setFont(font);
+    rateLabel = new QLabel;
+    rateLabel->setAlignment(Qt::AlignCenter);
+    rateLabel->setFont(font);
+    ackButton = new QPushButton("Acknowledge");
+    connect(ackButton,&QPushButton::clicked,[this](){ if (onAcknowledge) onAcknowledge(); });
+    setAlarm(AlarmManager::NORMAL, false, false);
+    setRateAlarm(false, false, 0);
+
     // set up the layout - button above thermometer
     vLayout = new QVBoxLayout();
     vLayout->setSpacing(10);  // set spacing between button and thermo
     vLayout->setContentsMargins(5, 5, 5, 5);  // set margin around the vertical layout
 
     vLayout->addWidget(button);
+    vLayout->addWidget(alarmLabel);
+    vLayout->addWidget(rateLabel);
+    vLayout->addWidget(ackButton);
     vLayout->addWidget(thermo);     
 
     // plot to the left of button and thermometer
@@ -93,6 +111,40 @@ Window::Window()
 Window::~Window() {  
 }
 
+void Window::setThresholds(double low, double high) {
+    std::lock_guard<std::mutex> lock(mtx);
+    lowThreshold = low;
+    highThreshold = high;
+}
+
+void Window::setAlarm(int condition, bool latched, bool acknowledged) {
+    QString text = "No alarm";
+    QString style = "QLabel { color: #00AA00; }";
+    if (condition != AlarmManager::NORMAL) {
+        text = AlarmManager::conditionName((AlarmManager::Condition)condition);
+        text[0] = text[0].toUpper();
+        if (latched) text += " (latched)";
+        else if (acknowledged) text += " (acknowledged)";
+        style = acknowledged ? "QLabel { color: #FF8800; }"
+                             : "QLabel { color: white; background-color: #FF0000; }";
+    }
+    alarmLabel->setText(text);
+    alarmLabel->setStyleSheet(style);
+    alarmPending = condition != AlarmManager::NORMAL && !acknowledged;
+    ackButton->setEnabled(onAcknowledge && (alarmPending || ratePending));
+}
+
+void Window::setRateAlarm(bool raised, bool acknowledged, double rate) {
+    rateLabel->setVisible(raised);
+    if (raised) {
+        rateLabel->setText(QString("Rising %1 °C/min").arg(rate, 0, 'f', 2));
+        rateLabel->setStyleSheet(acknowledged ? "QLabel { color: #FF8800; }"
+                                              : "QLabel { color: white; background-color: #FF0000; }");
+    }
+    ratePending = raised && !acknowledged;
+    ackButton->setEnabled(onAcknowledge && (alarmPending || ratePending));
+}
+
 void Window::reset() {
     std::lock_guard<std::mutex> lock(mtx);
 
@@ -170,7 +222,7 @@ void Window::updateTemperature(double temp) {
 }
 */
 ///* Auto scale as per visible data
-void Window::updateTemperature(double temp) {
+void Window::updateTemperature(double temp, qint64 timestampNs) {
     std::lock_guard<std::mutex> lock(mtx);
 
     // Shift data for rolling plot
@@ -179,9 +231,9 @@ void Window::updateTemperature(double temp) {
 
     // Determine the dynamic color based on temperature value
     QColor displayColor;
-    if (temp > TMP117TemperatureSensor::HIGH_THRESHOLD)
+    if (temp > highThreshold)
         displayColor = QColor("#FF0000");  // Red
-    else if (temp < TMP117TemperatureSensor::LOW_THRESHOLD)
+    else if (temp < lowThreshold)
         displayColor = QColor("#0000FF");  // Blue
     else
         displayColor = QColor("#00AA00");  // Green
@@ -189,7 +241,9 @@ void Window::updateTemperature(double temp) {
     // Update table
     QTableWidgetItem* tempItem = new QTableWidgetItem(QString::number(temp, 'f', 2));
     tempItem->setForeground(QBrush(displayColor)); 
-    table->setItem(0, 0, new QTableWidgetItem(QDateTime::currentDateTime().toString("hh:mm:ss")));
+    QDateTime sampleTime = timestampNs ? QDateTime::fromMSecsSinceEpoch(timestampNs / 1000000)
+                                       : QDateTime::currentDateTime();
+    table->setItem(0, 0, new QTableWidgetItem(sampleTime.toString("hh:mm:ss")));
     table->setItem(0, 1, tempItem);
 
     // Calculate new range from current data
@@ -16,7 +16,9 @@
 #include <QTableWidget>
 #include <QDateTime>
 #include <QHeaderView>
+#include <QLabel>
 
+#include <functional>
 #include <mutex>
 
 // class definition 'Window'. It inherits QWidget which inherits QObject.
@@ -28,10 +30,21 @@ class Window : public QWidget
 public:
     Window(); // default constructor - called when a Window is declared without arguments
     ~Window();
+
+    // temperature range shown in green, below in blue and above in red, can be changed from any thread
+    void setThresholds(double low, double high);
+
+    // called in the Qt main thread when the alarm is acknowledged with the button
+    std::function<void()> onAcknowledge;
  
 // mark the method as a slot to make it Q_INVOKABLE function    
 public slots:
-    void updateTemperature(double temp);
+    // timestampNs: wall clock time of the sample in ns since the epoch, 0 for "now"
+    void updateTemperature(double temp, qint64 timestampNs = 0);
+    // condition: AlarmManager::Condition of the sensor alarm, NORMAL (0) when clear
+    void setAlarm(int condition, bool latched, bool acknowledged);
+    // rate of change alarm of the sensor, rate in °C/min when it was raised
+    void setRateAlarm(bool raised, bool acknowledged, double rate);
 
 
 // internal variables for the window class
@@ -39,6 +52,13 @@ private:
     static constexpr int plotDataSize = 100;
 
     QPushButton  *button;
+    QPushButton  *ackButton;
+    QLabel       *alarmLabel;
+    QLabel       *rateLabel;
+
+    // alarms waiting for acknowledge
+    bool alarmPending = false;
+    bool ratePending = false;
     QwtThermo    *thermo;
     QwtPlot      *plot;
     QwtPlotCurve *curve;
@@ -56,6 +76,9 @@ private:
 
     long count = 0;
 
+    double lowThreshold;
+    double highThreshold;
+
     void reset();
 
     std::mutex mtx; 